@@ -0,0 +1,78 @@
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef TRACK_ALLOCATIONS
+// Per thread so that worker threads (frame capture, ...) don't show up in the game loop numbers
+static thread_local size_t allocationCount = 0;
+
+static void* trackedAlloc(size_t size) {
+    ++allocationCount;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(size_t size) {
+    void* p = trackedAlloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = trackedAlloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return trackedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return trackedAlloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+// Sized forms, C++14 compilers call these for objects of known size
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+bool AllocationTracker::enabled() {
+    return true;
+}
+
+size_t AllocationTracker::allocations() {
+    return allocationCount;
+}
+#else
+bool AllocationTracker::enabled() {
+    return false;
+}
+
+size_t AllocationTracker::allocations() {
+    return 0;
+}
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+
+/* Counts heap allocations made through operator new on the calling thread.
+Only active when built with TRACK_ALLOCATIONS (Debug configurations), otherwise the count stays 0. */
+namespace AllocationTracker {
+    bool enabled();
+    size_t allocations();
+}
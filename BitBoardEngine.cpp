@@ -0,0 +1,23 @@
+#include "BitBoardEngine.h"
+
+// Sizes compiled ahead of time, the board dimensions become constants in the hot paths
+template class BitBoardCore<FixedGrid<20, 20>>;
+template class BitBoardCore<FixedGrid<30, 30>>; // Default 600x600 board with 20px cells
+template class BitBoardCore<FixedGrid<40, 40>>;
+template class BitBoardCore<DynamicGrid>;
+
+std::unique_ptr<BoardEngine> createBoardEngine(int width, int height) {
+    if (width < 2 || height < 1 || width > MAX_BOARD_SIDE || height > MAX_BOARD_SIDE) {
+        return nullptr;
+    }
+    if (width == 20 && height == 20) {
+        return std::make_unique<BitBoardEngine<20, 20>>();
+    }
+    if (width == 30 && height == 30) {
+        return std::make_unique<BitBoardEngine<30, 30>>();
+    }
+    if (width == 40 && height == 40) {
+        return std::make_unique<BitBoardEngine<40, 40>>();
+    }
+    return std::make_unique<GenericBoardEngine>(width, height);
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Game rules of Game::update on a grid of cells instead of pixels.
+Occupancy, food and poo are bitboards (one bit per cell, row by row), the snake itself is a ring
+of cell indices so moving only touches the head and the tail. Used for bots and simulations
+that don't need SDL. */
+class BoardEngine
+{
+public:
+    enum class StepResult { MOVED, ATE_FOOD, DIED };
+
+    virtual ~BoardEngine() {}
+
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    virtual void reset(uint64_t seed) = 0;
+    virtual void setDirection(int dir) = 0; // Same encoding as Snake::setDirection
+    virtual StepResult step() = 0;
+
+    virtual int direction() const = 0;
+    virtual int score() const = 0;
+    virtual int length() const = 0;
+    virtual int segment(int i) const = 0; // Cell of the i-th segment, 0 is the head
+    virtual int foodCell() const = 0;
+    virtual int pooCell() const = 0; // -1 until the first poo spawns
+    virtual bool isOccupied(int cell) const = 0;
+
+    // Four width * height byte planes: snake, head, food, poo (1 where present, 0 elsewhere)
+    virtual void writeObservation(uint8_t* planes) const = 0;
+};
+
+// Picks a specialized engine for the common board sizes and the generic one otherwise.
+// nullptr when the size can't hold a game: the start cell needs a width of 2, and a side may be MAX_BOARD_SIDE at most
+static const int MAX_BOARD_SIDE = 4096;
+std::unique_ptr<BoardEngine> createBoardEngine(int width, int height);
+
+// Storage with the board size known at compile time, everything lives inline
+template <int W, int H>
+struct FixedGrid {
+    static const int CELLS = W * H;
+    static const int WORDS = (CELLS + 63) / 64;
+
+    std::array<uint64_t, WORDS> occupied;
+    std::array<uint64_t, WORDS> food;
+    std::array<uint64_t, WORDS> poo;
+    std::array<int32_t, CELLS + 1> body; // Ring of cell indices, head first
+
+    FixedGrid(int, int) {}
+    int width() const { return W; }
+    int height() const { return H; }
+    int cells() const { return CELLS; }
+    int words() const { return WORDS; }
+};
+
+// Storage for any board size, allocated once when the engine is created
+struct DynamicGrid {
+    int gridWidth;
+    int gridHeight;
+    std::vector<uint64_t> occupied;
+    std::vector<uint64_t> food;
+    std::vector<uint64_t> poo;
+    std::vector<int32_t> body;
+
+    DynamicGrid(int width, int height)
+        : gridWidth(width), gridHeight(height),
+          occupied((width * height + 63) / 64), food(occupied.size()), poo(occupied.size()),
+          body(width * height + 1) {}
+    int width() const { return gridWidth; }
+    int height() const { return gridHeight; }
+    int cells() const { return gridWidth * gridHeight; }
+    int words() const { return static_cast<int>(occupied.size()); }
+};
+
+template <class Grid>
+class BitBoardCore : public BoardEngine
+{
+public:
+    BitBoardCore(int width = 0, int height = 0) : grid(width, height) { reset(1); }
+
+    int width() const override { return grid.width(); }
+    int height() const override { return grid.height(); }
+
+    void reset(uint64_t seed) override {
+        std::fill(grid.occupied.begin(), grid.occupied.end(), 0);
+        std::fill(grid.food.begin(), grid.food.end(), 0);
+        std::fill(grid.poo.begin(), grid.poo.end(), 0);
+        rng = seed != 0 ? seed : 0x9E3779B97F4A7C15ULL;
+
+        // Same start as GameBoard, one cell left of the centre heading right
+        headIndex = 0;
+        snakeLength = 1;
+        pendingGrowth = 0;
+        grid.body[0] = cellAt(grid.width() / 2 - 1, grid.height() / 2);
+        setBit(grid.occupied, grid.body[0]);
+        currentDirection = RIGHT;
+        currentScore = 0;
+        food = -1;
+        poo = -1;
+        spawnFood();
+    }
+
+    void setDirection(int dir) override {
+        // Reversing into the neck is ignored, same as Snake::setDirection
+        if (dir == UP && currentDirection != DOWN) currentDirection = UP;
+        else if (dir == DOWN && currentDirection != UP) currentDirection = DOWN;
+        else if (dir == LEFT && currentDirection != RIGHT) currentDirection = LEFT;
+        else if (dir == RIGHT && currentDirection != LEFT) currentDirection = RIGHT;
+    }
+
+    StepResult step() override {
+        const int w = grid.width();
+        const int h = grid.height();
+        int head = grid.body[headIndex];
+        int x = head % w;
+        int y = head / w;
+
+        // Wrap around the edges like Snake::moveSnake
+        int next;
+        switch (currentDirection) {
+        case UP:    next = y == 0 ? head + (h - 1) * w : head - w; break;
+        case DOWN:  next = y == h - 1 ? x : head + w; break;
+        case LEFT:  next = x == 0 ? head + w - 1 : head - 1; break;
+        default:    next = x == w - 1 ? head - w + 1 : head + 1; break;
+        }
+
+        // The tail moves out of the way unless the snake is still growing, so its cell counts as free then.
+        // Nothing is changed before this test: a dying step leaves the board as it was
+        const int tail = grid.body[tailIndex()];
+        const bool tailMoves = pendingGrowth == 0;
+        int word = next >> 6;
+        uint64_t mask = 1ULL << (next & 63);
+        if ((grid.poo[word] & mask) || ((grid.occupied[word] & mask) && !(tailMoves && next == tail))) {
+            return StepResult::DIED;
+        }
+
+        if (tailMoves) {
+            clearBit(grid.occupied, tail);
+            --snakeLength;
+        }
+        else {
+            --pendingGrowth;
+        }
+
+        headIndex = headIndex == 0 ? ringSize() - 1 : headIndex - 1;
+        grid.body[headIndex] = next;
+        grid.occupied[word] |= mask;
+        ++snakeLength;
+
+        if (grid.food[word] & mask) {
+            grid.food[word] &= ~mask;
+            ++pendingGrowth;
+            currentScore += 10;
+            spawnFood();
+            if (currentScore >= 100) {
+                spawnPoo();
+            }
+            return StepResult::ATE_FOOD;
+        }
+        return StepResult::MOVED;
+    }
+
+    int direction() const override { return currentDirection; }
+    int score() const override { return currentScore; }
+    int length() const override { return snakeLength; }
+    int segment(int i) const override { return grid.body[(headIndex + i) % ringSize()]; }
+    int foodCell() const override { return food; }
+    int pooCell() const override { return poo; }
+    bool isOccupied(int cell) const override { return (grid.occupied[cell >> 6] >> (cell & 63)) & 1; }
+
+    void writeObservation(uint8_t* planes) const override {
+        const int cells = grid.cells();
+        std::memset(planes, 0, static_cast<size_t>(cells) * 4);
+
+        // Expand the occupancy bitboard a set bit at a time
+        for (int word = 0; word < grid.words(); ++word) {
+            uint64_t bits = grid.occupied[word];
+            while (bits != 0) {
+                planes[(word << 6) + lowestBit(bits)] = 1;
+                bits &= bits - 1;
+            }
+        }
+        planes[cells + grid.body[headIndex]] = 1;
+        if (food >= 0) {
+            planes[2 * cells + food] = 1;
+        }
+        if (poo >= 0) {
+            planes[3 * cells + poo] = 1;
+        }
+    }
+
+private:
+    enum { UP = 0, DOWN = 1, LEFT = 2, RIGHT = 3 };
+
+    Grid grid;
+    int headIndex = 0;
+    int snakeLength = 0;
+    int pendingGrowth = 0;
+    int currentDirection = RIGHT;
+    int currentScore = 0;
+    int food = -1;
+    int poo = -1;
+    uint64_t rng = 1;
+
+    int ringSize() const { return grid.cells() + 1; }
+    int tailIndex() const { return (headIndex + snakeLength - 1) % ringSize(); }
+    int cellAt(int x, int y) const { return y * grid.width() + x; }
+
+    template <class Words>
+    static void setBit(Words& words, int cell) { words[cell >> 6] |= 1ULL << (cell & 63); }
+    template <class Words>
+    static void clearBit(Words& words, int cell) { words[cell >> 6] &= ~(1ULL << (cell & 63)); }
+
+    static int lowestBit(uint64_t bits) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#elif defined(_MSC_VER)
+        // 32-bit targets only have the 32-bit scan, look at the high half when the low one is empty
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<uint32_t>(bits))) {
+            return static_cast<int>(index);
+        }
+        _BitScanForward(&index, static_cast<uint32_t>(bits >> 32));
+        return static_cast<int>(index) + 32;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    uint64_t nextRandom() {
+        // xorshift64*, cheap and deterministic per seed
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return rng * 0x2545F4914F6CDD1DULL;
+    }
+
+    // First free cell at or after a random start, found a word at a time. -1 if the board is full
+    int randomFreeCell() {
+        const int cells = grid.cells();
+        const int words = grid.words();
+        int start = static_cast<int>(nextRandom() % cells);
+        int startWord = start >> 6;
+        for (int i = 0; i <= words; ++i) {
+            int word = (startWord + i) % words;
+            uint64_t free = ~(grid.occupied[word] | grid.food[word] | grid.poo[word]);
+            if (i == 0) {
+                free &= ~0ULL << (start & 63); // Only from the start cell on
+            }
+            else if (i == words) {
+                free &= (1ULL << (start & 63)) - 1; // Back in the first word, the part before the start
+            }
+            if (word == words - 1 && (cells & 63) != 0) {
+                free &= (1ULL << (cells & 63)) - 1; // Bits past the last cell
+            }
+            if (free != 0) {
+                return (word << 6) + lowestBit(free);
+            }
+        }
+        return -1;
+    }
+
+    void spawnFood() {
+        food = randomFreeCell();
+        if (food >= 0) {
+            setBit(grid.food, food);
+        }
+    }
+
+    void spawnPoo() {
+        if (poo >= 0) {
+            clearBit(grid.poo, poo);
+        }
+        poo = randomFreeCell();
+        if (poo >= 0) {
+            setBit(grid.poo, poo);
+        }
+    }
+};
+
+template <int W, int H>
+using BitBoardEngine = BitBoardCore<FixedGrid<W, H>>;
+using GenericBoardEngine = BitBoardCore<DynamicGrid>;
+
+// Precompiled in BitBoardEngine.cpp
+extern template class BitBoardCore<FixedGrid<20, 20>>;
+extern template class BitBoardCore<FixedGrid<30, 30>>;
+extern template class BitBoardCore<FixedGrid<40, 40>>;
+extern template class BitBoardCore<DynamicGrid>;
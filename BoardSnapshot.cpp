@@ -0,0 +1,82 @@
+#include "BoardSnapshot.h"
+#include "GameBoard.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+bool BoardSnapshot::isValid() const {
+    if (length == 0 || length > MAX_SEGMENTS || direction > 3) {
+        return false;
+    }
+    if (foodCell < 0 || foodCell >= BOARD_CELLS || pooCell < -1 || pooCell >= BOARD_CELLS) {
+        return false; // Only the poo may be missing
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (segments[i] >= BOARD_CELLS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void benchmarkSnapshots() {
+    const int iterations = 100000;
+    const int lengths[] = { 1, 10, 100, 450, 900 };
+    typedef std::chrono::high_resolution_clock Clock;
+
+    GameBoard board;
+    BoardSnapshot snapshot;
+    std::vector<BoardSnapshot> branches(16);
+    unsigned long checksum = 0; // Read from every copy and printed, so the copies can't be optimized away
+
+    std::cout << "length  save(ns)  restore(ns)  clone(ns)  cow-branch(ns)  deep-copy(ns)" << std::endl;
+    for (int length : lengths) {
+        // Lay the snake out row by row so every segment has its own cell
+        board.snake->body.clear();
+        for (int i = 0; i < length; ++i) {
+            board.snake->growSnake((i % BoardSnapshot::COLUMNS) * Snake::BODY_SEGMENT_SIZE, (i / BoardSnapshot::COLUMNS) * Snake::BODY_SEGMENT_SIZE);
+        }
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            board.saveSnapshot(snapshot);
+        }
+        double saveNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            board.restoreSnapshot(snapshot);
+        }
+        double restoreNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            BoardSnapshot& branch = branches[i % branches.size()];
+            snapshot.cloneInto(branch);
+            checksum += branch.segments[branch.length - 1];
+        }
+        double cloneNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+        // A branch that is written to pays for one clone, untouched branches only share
+        SharedBoardSnapshot root(snapshot);
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            SharedBoardSnapshot branch = root;
+            if (i % 2 == 0) {
+                branch.write().direction = static_cast<uint8_t>(i & 3);
+            }
+        }
+        double cowNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+        // What copying the board costs without snapshots
+        start = Clock::now();
+        for (int i = 0; i < iterations / 10; ++i) {
+            Snake copy = *board.snake;
+            checksum += copy.body.size() + copy.body.back().x;
+        }
+        double deepCopyNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (iterations / 10);
+
+        std::cout << length << "  " << saveNs << "  " << restoreNs << "  " << cloneNs << "  " << cowNs << "  " << deepCopyNs << std::endl;
+    }
+    std::cout << "checksum " << checksum << std::endl;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+/* Compact copy of everything on a GameBoard.
+Segments are stored as cell indices (row * columns + column), head first. The struct is
+trivially copyable so it can be memcpy'd, kept in arrays or written to disk as is. */
+struct BoardSnapshot {
+    static const int COLUMNS = 30; // GameBoard::BOARD_WIDTH / GameBoard::FOOD_SEGMENT_SIZE
+    static const int ROWS = 30;    // GameBoard::BOARD_HEIGHT / GameBoard::FOOD_SEGMENT_SIZE
+    static const int BOARD_CELLS = COLUMNS * ROWS;
+    static const int MAX_SEGMENTS = BOARD_CELLS + 1;
+
+    uint16_t length;
+    uint8_t direction; // Snake::Direction
+    int16_t foodCell;
+    int16_t pooCell; // -1 when there is no poo on the board
+    uint16_t segments[MAX_SEGMENTS];
+
+    // Bytes actually in use, the unused tail of segments is never read
+    size_t usedBytes() const { return offsetof(BoardSnapshot, segments) + length * sizeof(uint16_t); }
+
+    // Copies only the used part, so cloning a short snake is cheaper than a full struct copy
+    void cloneInto(BoardSnapshot& target) const { std::memcpy(&target, this, usedBytes()); }
+
+    // Every cell on the board and a known direction, for snapshots read from outside (save files)
+    bool isValid() const;
+};
+
+static_assert(std::is_trivially_copyable<BoardSnapshot>::value, "BoardSnapshot must stay trivially copyable");
+
+/* Copy-on-write handle to a snapshot for branching searches.
+Copies of the handle share one snapshot until one of them is written to. */
+class SharedBoardSnapshot
+{
+public:
+    explicit SharedBoardSnapshot(const BoardSnapshot& snapshot) : state(std::make_shared<BoardSnapshot>()) { snapshot.cloneInto(*state); }
+
+    const BoardSnapshot& read() const { return *state; }
+
+    BoardSnapshot& write() {
+        if (state.use_count() > 1) {
+            std::shared_ptr<BoardSnapshot> copy = std::make_shared<BoardSnapshot>();
+            state->cloneInto(*copy);
+            state = copy;
+        }
+        return *state;
+    }
+
+private:
+    std::shared_ptr<BoardSnapshot> state;
+};
+
+// Prints save, restore and clone timings for a range of snake lengths
+void benchmarkSnapshots();
@@ -0,0 +1,204 @@
+#include "ChunkedWorld.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const char MAP_MAGIC[4] = { 'S', 'N', 'W', 'M' };
+static const uint32_t MAP_VERSION = 1;
+
+// Between one chunk and MAX_SIZE, rounded up to whole chunks so wrapping around the edge never splits a chunk
+static int worldSize(int cells) {
+    if (cells < 1) {
+        cells = 1;
+    }
+    else if (cells > ChunkedWorld::MAX_SIZE) {
+        cells = ChunkedWorld::MAX_SIZE;
+    }
+    return (cells + ChunkedWorld::CHUNK_SIZE - 1) / ChunkedWorld::CHUNK_SIZE * ChunkedWorld::CHUNK_SIZE;
+}
+
+ChunkedWorld::ChunkedWorld(int width, int height) : worldWidth(worldSize(width)), worldHeight(worldSize(height)) {}
+
+bool ChunkedWorld::openMap(const std::string& path) {
+    if (!map.open(path)) {
+        return false;
+    }
+
+    MapHeader header;
+    if (map.size() < sizeof(header)) {
+        map.close();
+        return false;
+    }
+    std::memcpy(&header, map.data(), sizeof(header));
+    // Compared as an entry count, the size in bytes could overflow size_t on 32-bit builds
+    size_t maxEntries = (map.size() - sizeof(header)) / sizeof(MapDirectoryEntry);
+    if (std::memcmp(header.magic, MAP_MAGIC, 4) != 0 || header.version != MAP_VERSION ||
+        header.chunkSize != CHUNK_SIZE || header.chunkCount > maxEntries ||
+        header.width <= 0 || header.height <= 0 || header.width > MAX_SIZE || header.height > MAX_SIZE ||
+        header.width % CHUNK_SIZE != 0 || header.height % CHUNK_SIZE != 0) {
+        std::cerr << "Invalid world map " << path << "!" << std::endl;
+        map.close();
+        return false;
+    }
+
+    // Only the header and the directory are read now, chunks follow when they are needed.
+    // Every entry is checked once here so pageIn can trust them: inside the world, payload inside
+    // the file and keys strictly increasing for the binary search
+    const MapDirectoryEntry* entries = reinterpret_cast<const MapDirectoryEntry*>(map.data() + sizeof(header));
+    const uint64_t chunkBytes = CHUNK_SIZE * CHUNK_SIZE;
+    for (uint32_t i = 0; i < header.chunkCount; ++i) {
+        const MapDirectoryEntry& entry = entries[i];
+        if (entry.chunkX >= static_cast<uint32_t>(header.width / CHUNK_SIZE) || entry.chunkY >= static_cast<uint32_t>(header.height / CHUNK_SIZE) ||
+            entry.offset > map.size() || map.size() - entry.offset < chunkBytes ||
+            (i > 0 && chunkKey(entry.chunkX, entry.chunkY) <= chunkKey(entries[i - 1].chunkX, entries[i - 1].chunkY))) {
+            std::cerr << "Invalid world map " << path << "! Bad chunk entry " << i << std::endl;
+            map.close();
+            return false;
+        }
+    }
+    worldWidth = header.width;
+    worldHeight = header.height;
+    directory = entries;
+    directorySize = header.chunkCount;
+    chunks.clear();
+    loadedCount = 0;
+    lastKey = UINT64_MAX;
+    lastChunk = nullptr;
+    return true;
+}
+
+bool ChunkedWorld::saveMap(const std::string& path) {
+    // Page everything in first, the file being written may be the one that is mapped
+    for (uint32_t i = 0; i < directorySize; ++i) {
+        pageIn(chunkKey(directory[i].chunkX, directory[i].chunkY));
+    }
+    map.close();
+    directory = nullptr;
+    directorySize = 0;
+
+    std::vector<uint64_t> keys;
+    for (const auto& item : chunks) {
+        if (item.second) {
+            keys.push_back(item.first);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write world map " << path << "!" << std::endl;
+        return false;
+    }
+    MapHeader header;
+    std::memcpy(header.magic, MAP_MAGIC, 4);
+    header.version = MAP_VERSION;
+    header.width = worldWidth;
+    header.height = worldHeight;
+    header.chunkSize = CHUNK_SIZE;
+    header.chunkCount = static_cast<uint32_t>(keys.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t offset = sizeof(header) + keys.size() * sizeof(MapDirectoryEntry);
+    for (uint64_t key : keys) {
+        MapDirectoryEntry entry = { static_cast<uint32_t>(key & 0xFFFFFFFF), static_cast<uint32_t>(key >> 32), offset };
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset += CHUNK_SIZE * CHUNK_SIZE;
+    }
+    for (uint64_t key : keys) {
+        file.write(reinterpret_cast<const char*>(chunks[key]->cells), CHUNK_SIZE * CHUNK_SIZE);
+    }
+    return static_cast<bool>(file);
+}
+
+uint8_t ChunkedWorld::get(int x, int y) {
+    const Chunk* chunk = findChunk(x, y, false);
+    if (chunk == nullptr) {
+        return EMPTY;
+    }
+    return chunk->cells[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+}
+
+void ChunkedWorld::set(int x, int y, uint8_t cell) {
+    Chunk* chunk = findChunk(x, y, cell != EMPTY);
+    if (chunk == nullptr) {
+        return; // Clearing a cell that is already empty
+    }
+
+    uint8_t& current = chunk->cells[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+    if (current == EMPTY && cell != EMPTY) {
+        ++chunk->used;
+    }
+    else if (current != EMPTY && cell == EMPTY) {
+        --chunk->used;
+    }
+    current = cell;
+
+    // Give the memory of chunks that became empty back
+    if (chunk->used == 0) {
+        uint64_t key = chunkKey(x / CHUNK_SIZE, y / CHUNK_SIZE);
+        if (directorySize == 0) {
+            chunks.erase(key);
+        }
+        else {
+            chunks[key].reset(); // Keep the empty marker so the mapped copy isn't paged in again
+        }
+        --loadedCount;
+        lastKey = UINT64_MAX;
+        lastChunk = nullptr;
+    }
+}
+
+ChunkedWorld::Chunk* ChunkedWorld::findChunk(int x, int y, bool create) {
+    if (x < 0 || y < 0 || x >= worldWidth || y >= worldHeight) {
+        return nullptr;
+    }
+    uint64_t key = chunkKey(x / CHUNK_SIZE, y / CHUNK_SIZE);
+    if (key == lastKey && (lastChunk != nullptr || !create)) {
+        return lastChunk;
+    }
+
+    Chunk* chunk = pageIn(key);
+    if (chunk == nullptr && create) {
+        std::unique_ptr<Chunk>& slot = chunks[key];
+        slot.reset(new Chunk());
+        std::memset(slot->cells, EMPTY, sizeof(slot->cells));
+        slot->used = 0;
+        ++loadedCount;
+        chunk = slot.get();
+    }
+    lastKey = key;
+    lastChunk = chunk;
+    return chunk;
+}
+
+ChunkedWorld::Chunk* ChunkedWorld::pageIn(uint64_t key) {
+    auto found = chunks.find(key);
+    if (found != chunks.end()) {
+        return found->second.get();
+    }
+
+    // Binary search the mapped directory, it is sorted by key
+    const MapDirectoryEntry* begin = directory;
+    const MapDirectoryEntry* end = directory + directorySize;
+    const MapDirectoryEntry* entry = std::lower_bound(begin, end, key, [](const MapDirectoryEntry& e, uint64_t k) {
+        return chunkKey(e.chunkX, e.chunkY) < k;
+        });
+    if (entry == end || chunkKey(entry->chunkX, entry->chunkY) != key ||
+        entry->offset > map.size() || map.size() - entry->offset < CHUNK_SIZE * CHUNK_SIZE) {
+        return nullptr; // Nothing stored there, stays unallocated
+    }
+
+    std::unique_ptr<Chunk> chunk(new Chunk());
+    std::memcpy(chunk->cells, map.data() + entry->offset, sizeof(chunk->cells));
+    chunk->used = static_cast<uint32_t>(CHUNK_SIZE * CHUNK_SIZE - std::count(chunk->cells, chunk->cells + CHUNK_SIZE * CHUNK_SIZE, EMPTY));
+    if (chunk->used == 0) {
+        chunks[key] = nullptr;
+        return nullptr;
+    }
+    Chunk* raw = chunk.get();
+    chunks[key] = std::move(chunk);
+    ++loadedCount;
+    return raw;
+}
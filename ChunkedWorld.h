@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "MappedFile.h"
+
+/* Sparse world made of fixed size chunks of cells.
+A chunk only exists where something lies, so memory follows the occupied area instead of the
+world size. Maps are memory mapped and a chunk is copied out of the file the first time it is
+touched.
+
+Map file: header, then a directory of chunk coordinates and file offsets sorted by
+(chunkY, chunkX), then the raw cells of every stored chunk. */
+class ChunkedWorld
+{
+public:
+    enum Cell : uint8_t { EMPTY = 0, FOOD = 1, POO = 2, WALL = 3 };
+    static const int CHUNK_SIZE = 32; // Cells per side
+    static const int MAX_SIZE = 1000000;
+
+    ChunkedWorld(int width, int height);
+
+    bool openMap(const std::string& path);
+    bool saveMap(const std::string& path);
+
+    int width() const { return worldWidth; }
+    int height() const { return worldHeight; }
+    uint8_t get(int x, int y);
+    void set(int x, int y, uint8_t cell);
+
+    size_t loadedChunks() const { return loadedCount; }
+    size_t memoryBytes() const { return loadedCount * sizeof(Chunk); }
+
+private:
+    struct Chunk {
+        uint8_t cells[CHUNK_SIZE * CHUNK_SIZE];
+        uint32_t used; // Non-empty cells, the chunk is freed when this reaches 0
+    };
+
+#pragma pack(push, 1)
+    struct MapHeader {
+        char magic[4];
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        uint32_t chunkSize;
+        uint32_t chunkCount;
+    };
+    struct MapDirectoryEntry {
+        uint32_t chunkX;
+        uint32_t chunkY;
+        uint64_t offset;
+    };
+#pragma pack(pop)
+
+    int worldWidth;
+    int worldHeight;
+    // A null chunk means "known to be empty", it stops the chunk from being paged in again
+    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+    size_t loadedCount = 0;
+    MappedFile map;
+    const MapDirectoryEntry* directory = nullptr;
+    uint32_t directorySize = 0;
+
+    // Last chunk looked up, neighbouring cells usually share it
+    uint64_t lastKey = UINT64_MAX;
+    Chunk* lastChunk = nullptr;
+
+    static uint64_t chunkKey(uint32_t chunkX, uint32_t chunkY) { return (static_cast<uint64_t>(chunkY) << 32) | chunkX; }
+    Chunk* findChunk(int x, int y, bool create);
+    Chunk* pageIn(uint64_t key);
+};
+
+// Window onto the world that keeps a cell (the snake head) in the middle, wrapping at the edges
+struct WorldCamera {
+    int x = 0; // Top left visible cell
+    int y = 0;
+    int columns = 0;
+    int rows = 0;
+
+    void follow(int cellX, int cellY, int worldWidth, int worldHeight) {
+        x = ((cellX - columns / 2) % worldWidth + worldWidth) % worldWidth;
+        y = ((cellY - rows / 2) % worldHeight + worldHeight) % worldHeight;
+    }
+};
@@ -0,0 +1,174 @@
+#include "FrameCapture.h"
+#include <SDL_image.h>
+#include <cstdio>
+#include <iostream>
+#include <cerrno>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Creates the capture directory, an existing one is fine
+static bool makeDirectory(const std::string& path) {
+#ifdef _WIN32
+    int result = _mkdir(path.c_str());
+#else
+    int result = mkdir(path.c_str(), 0755);
+#endif
+    return result == 0 || errno == EEXIST;
+}
+
+FrameCapture::FrameCapture() : captured(0), written(0), dropped(0), failed(0) {}
+
+FrameCapture::~FrameCapture() {
+    stop();
+}
+
+bool FrameCapture::start(const std::string& directory, Format format, int width, int height) {
+    if (active) {
+        return true;
+    }
+    this->directory = directory;
+    this->format = format;
+    this->width = width;
+    this->height = height;
+
+    if (!makeDirectory(directory)) {
+        std::cerr << "Failed to create capture directory " << directory << "!" << std::endl;
+        return false;
+    }
+
+    if (format == Format::RAW) {
+        // All raw frames go into one file, the name tells how to read it back
+        std::string path = directory + "/frames_" + std::to_string(width) + "x" + std::to_string(height) + "_rgba.raw";
+        rawFile = std::fopen(path.c_str(), "wb");
+        if (rawFile == nullptr) {
+            std::cerr << "Failed to open capture file " << path << "!" << std::endl;
+            return false;
+        }
+    }
+
+    // Allocate the whole ring up front, capturing itself never allocates
+    for (FrameSlot& slot : ring) {
+        slot.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+        slot.frameNumber = 0;
+    }
+    writeIndex = 0;
+    readIndex = 0;
+    filledSlots = 0;
+    frameCounter = 0;
+    captured = 0;
+    written = 0;
+    dropped = 0;
+    failed = 0;
+    stopping = false;
+
+    writer = std::thread(&FrameCapture::writerLoop, this);
+    active = true;
+    return true;
+}
+
+void FrameCapture::stop() {
+    if (!active) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameReady.notify_one();
+    writer.join(); // The writer drains the frames still in the ring before it exits
+    active = false;
+
+    if (rawFile != nullptr) {
+        std::fclose(rawFile);
+        rawFile = nullptr;
+    }
+
+    std::cout << "Capture finished: " << captured << " captured, " << written << " written, " << dropped << " dropped, " << failed << " failed to write" << std::endl;
+}
+
+void FrameCapture::captureFrame(SDL_Renderer* renderer) {
+    if (!active) {
+        return;
+    }
+    unsigned long frameNumber = frameCounter++;
+
+    FrameSlot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (filledSlots == RING_SIZE) {
+            // The disk can't keep up, drop this frame instead of waiting for the writer
+            ++dropped;
+            return;
+        }
+        slot = &ring[writeIndex];
+    }
+
+    // The slot is not visible to the writer until it is published below, so no lock is held here
+    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA32, slot->pixels.data(), width * 4) != 0) {
+        std::cerr << "Failed to read frame back! SDL Error: " << SDL_GetError() << std::endl;
+        ++failed;
+        return;
+    }
+    slot->frameNumber = frameNumber;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        writeIndex = (writeIndex + 1) % RING_SIZE;
+        ++filledSlots;
+    }
+    ++captured;
+    frameReady.notify_one();
+}
+
+void FrameCapture::writerLoop() {
+    while (true) {
+        FrameSlot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameReady.wait(lock, [this] { return filledSlots > 0 || stopping; });
+            if (filledSlots == 0) {
+                return; // Stopping and nothing left to write
+            }
+            slot = &ring[readIndex];
+        }
+
+        if (writeFrame(*slot)) {
+            ++written;
+        }
+        else {
+            ++failed;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readIndex = (readIndex + 1) % RING_SIZE;
+            --filledSlots;
+        }
+    }
+}
+
+bool FrameCapture::writeFrame(const FrameSlot& slot) {
+    if (format == Format::RAW) {
+        return std::fwrite(slot.pixels.data(), 1, slot.pixels.size(), rawFile) == slot.pixels.size();
+    }
+
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "/frame_%06lu.png", slot.frameNumber);
+    std::string path = directory + fileName;
+
+    // Wrap the slot memory, the surface does not own or copy the pixels
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<Uint8*>(slot.pixels.data()), width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32);
+    if (surface == nullptr) {
+        std::cerr << "Failed to wrap captured frame! SDL Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    bool saved = IMG_SavePNG(surface, path.c_str()) == 0;
+    if (!saved) {
+        std::cerr << "Failed to save " << path << "! IMG Error: " << IMG_GetError() << std::endl;
+    }
+    SDL_FreeSurface(surface);
+    return saved;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Records rendered frames to disk without stalling the game loop.
+Frames are read back into a small ring of preallocated pixel buffers and a worker thread
+writes them out a few frames behind. When the ring is full the frame is dropped and counted,
+frames the disk refused are counted as failed. */
+class FrameCapture
+{
+public:
+    enum class Format { RAW, PNG };
+
+    FrameCapture();
+    ~FrameCapture();
+
+    bool start(const std::string& directory, Format format, int width, int height);
+    void stop();
+    void captureFrame(SDL_Renderer* renderer); // Call after drawing and before SDL_RenderPresent
+    bool isActive() const { return active; }
+
+    unsigned long capturedFrames() const { return captured; }
+    unsigned long writtenFrames() const { return written; }
+    unsigned long droppedFrames() const { return dropped; }
+    unsigned long failedFrames() const { return failed; }
+
+private:
+    static const int RING_SIZE = 4; // How many frames the writer may fall behind
+
+    struct FrameSlot {
+        std::vector<Uint8> pixels;
+        unsigned long frameNumber;
+    };
+
+    FrameSlot ring[RING_SIZE];
+    int writeIndex = 0;  // Next slot filled by the game loop
+    int readIndex = 0;   // Next slot written to disk
+    int filledSlots = 0; // Guarded by mutex
+
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::thread writer;
+    bool stopping = false;
+    bool active = false;
+
+    std::string directory;
+    Format format = Format::RAW;
+    int width = 0;
+    int height = 0;
+    FILE* rawFile = nullptr;
+    unsigned long frameCounter = 0;
+
+    std::atomic<unsigned long> captured;
+    std::atomic<unsigned long> written;
+    std::atomic<unsigned long> dropped;
+    std::atomic<unsigned long> failed;
+
+    void writerLoop();
+    bool writeFrame(const FrameSlot& slot);
+};
@@ -6,12 +6,29 @@
 #include "Game.h"
 #include <fstream>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
+#include <climits>
 #include <nlohmann/json.hpp>
+#include "AllocationTracker.h"
+#include "LeaderboardView.h"
 
 using json = nlohmann::json;
 
-Game::Game() {
+// Layout of savegame.bin, the board part is the snapshot as is
+struct SavedGame {
+    char magic[4];
+    uint32_t version;
+    int32_t score;
+    char playerName[64];
+    BoardSnapshot board;
+};
+
+static const char SAVE_FILE[] = "savegame.bin";
+static const uint32_t SAVE_VERSION = 1;
+
+Game::Game(const GameOptions& options) : options(options) {
     if (!initSDL()) {
         std::cerr << "Failed to initialize SDL." << std::endl;
         exit(1); // Exiting if SDL fails to initialize
@@ -19,15 +36,40 @@ Game::Game() {
 
     // Initialize the game state
     gameRunning = true;
-    currentState = MAIN_MENU;
+    currentState = options.spectateBoards > 0 ? SPECTATOR : MAIN_MENU;
     board = new GameBoard();
     loadLeaderboard();
+    savedGameAvailable = std::ifstream(SAVE_FILE).good();
+    if (!options.worldPath.empty() && !loadWorld()) {
+        std::cerr << "World mode disabled." << std::endl;
+    }
     loadTextures(); // Load textures for ingame objects
+    createBoardLayer(); // Falls back to drawing straight to the window if render targets are missing
+
+    if (options.trackAllocations && !AllocationTracker::enabled()) {
+        std::cerr << "Warning: Built without TRACK_ALLOCATIONS, allocations are not counted!" << std::endl;
+    }
+
+    // Start recording if asked to
+    if (!options.captureDirectory.empty()) {
+        FrameCapture::Format format = options.capturePng ? FrameCapture::Format::PNG : FrameCapture::Format::RAW;
+        if (!frameCapture.start(options.captureDirectory, format, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            std::cerr << "Frame capture disabled." << std::endl;
+        }
+    }
     loadMusic(); // Load music for different game states
+
+    // A hidden window never gets key presses, skip the menu and let the bot play
+    if (options.headless && currentState == MAIN_MENU) {
+        playerName = "headless";
+        currentState = IN_GAME;
+        resetGame();
+    }
 }
 
 Game::~Game() {
     closeSDL();
+    delete board;
 }
 
 bool Game::initSDL() {
@@ -43,7 +85,8 @@ bool Game::initSDL() {
     }
 
     // Create window
-    window = SDL_CreateWindow("SNEJK", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
+    Uint32 windowFlags = options.headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN;
+    window = SDL_CreateWindow("SNEJK", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT, windowFlags);
     if (window == nullptr) {
         std::cerr << "Window could not be created! SDL Error: " << SDL_GetError() << std::endl;
         SDL_Quit();
@@ -59,6 +102,18 @@ bool Game::initSDL() {
         return false;
     }
 
+    // A hidden window has no usable backbuffer, headless frames are rendered offscreen instead
+    if (options.headless) {
+        frameTarget = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+        if (frameTarget == nullptr) {
+            std::cerr << "Offscreen target could not be created! SDL Error: " << SDL_GetError() << std::endl;
+            SDL_DestroyRenderer(renderer);
+            SDL_DestroyWindow(window);
+            SDL_Quit();
+            return false;
+        }
+    }
+
     // Initialize renderer color to black
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
 
@@ -110,101 +165,33 @@ bool Game::initSDL() {
 }
 
 void Game::loadTextures() {
-    // Load the snake head textures for each direction
-    SDL_Surface* tempSurface = IMG_Load("snake_head_up.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load snake head up texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    snakeHeadUpTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    tempSurface = IMG_Load("snake_head_down.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load snake head down texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    snakeHeadDownTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    tempSurface = IMG_Load("snake_head_left.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load snake head left texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    snakeHeadLeftTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    tempSurface = IMG_Load("snake_head_right.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load snake head right texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    snakeHeadRightTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the snake body texture
-    tempSurface = IMG_Load("snake_body.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load snake body texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    snakeBodyTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the snake tail texture
-    tempSurface = IMG_Load("snake_body.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load snake tail texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    snakeTailTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the food texture
-    tempSurface = IMG_Load("food.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load food texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    foodTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the poo texture
-    tempSurface = IMG_Load("poo.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load poo texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    pooTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the field texture
-    tempSurface = IMG_Load("field.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load field texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    fieldTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the starting screen texture
-    tempSurface = IMG_Load("start_screen.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load starting screen texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
-    }
-    startScreenTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
-
-    // Load the game over screen texture
-    tempSurface = IMG_Load("TheEND.png");
-    if (tempSurface == nullptr) {
-        std::cerr << "Failed to load starting screen texture! IMG Error: " << IMG_GetError() << std::endl;
-        return;
+    textures.init(renderer, options.textureBudgetMB * 1024 * 1024);
+
+    struct TextureFile {
+        TextureHandle* handle;
+        const char* path;
+        const char* description;
+    };
+    const TextureFile files[] = {
+        { &snakeHeadUpTexture, "snake_head_up.png", "snake head up" },
+        { &snakeHeadDownTexture, "snake_head_down.png", "snake head down" },
+        { &snakeHeadLeftTexture, "snake_head_left.png", "snake head left" },
+        { &snakeHeadRightTexture, "snake_head_right.png", "snake head right" },
+        { &snakeBodyTexture, "snake_body.png", "snake body" },
+        { &snakeTailTexture, "snake_body.png", "snake tail" }, // Same file as the body, shares its texture
+        { &foodTexture, "food.png", "food" },
+        { &pooTexture, "poo.png", "poo" },
+        { &fieldTexture, "field.png", "field" },
+        { &startScreenTexture, "start_screen.png", "starting screen" },
+        { &endScreenTexture, "TheEND.png", "game over screen" },
+    };
+
+    for (const TextureFile& file : files) {
+        *file.handle = textures.load(file.path);
+        if (!*file.handle) {
+            std::cerr << "Failed to load " << file.description << " texture! IMG Error: " << IMG_GetError() << std::endl;
+        }
     }
-    endScreenTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
 }
 
 void Game::loadMusic() {
@@ -240,50 +227,28 @@ void Game::loadMusic() {
 }
 
 void Game::closeSDL() {
-    // Destroy the textures
-    if (snakeHeadUpTexture != nullptr) {
-        SDL_DestroyTexture(snakeHeadUpTexture);
-        snakeHeadUpTexture = nullptr;
-    }
-    if (snakeHeadDownTexture != nullptr) {
-        SDL_DestroyTexture(snakeHeadDownTexture);
-        snakeHeadDownTexture = nullptr;
-    }
-    if (snakeHeadLeftTexture != nullptr) {
-        SDL_DestroyTexture(snakeHeadLeftTexture);
-        snakeHeadLeftTexture = nullptr;
-    }
-    if (snakeHeadRightTexture != nullptr) {
-        SDL_DestroyTexture(snakeHeadRightTexture);
-        snakeHeadRightTexture = nullptr;
-    }
-    if (snakeBodyTexture != nullptr) {
-        SDL_DestroyTexture(snakeBodyTexture);
-        snakeBodyTexture = nullptr;
-    }
-    if (snakeTailTexture != nullptr) {
-        SDL_DestroyTexture(snakeTailTexture);
-        snakeTailTexture = nullptr;
-    }
-    if (foodTexture != nullptr) {
-        SDL_DestroyTexture(foodTexture);
-        foodTexture = nullptr;
-    }
-    if (pooTexture != nullptr) {
-        SDL_DestroyTexture(pooTexture);
-        pooTexture = nullptr;
-    }
-    if (fieldTexture != nullptr) {
-        SDL_DestroyTexture(fieldTexture);
-        fieldTexture = nullptr;
-    }
-    if (startScreenTexture != nullptr) {
-        SDL_DestroyTexture(startScreenTexture);
-        startScreenTexture = nullptr;
+    // Flush the frames still waiting to be written
+    frameCapture.stop();
+
+    // Destroy the spectator wall and its atlas
+    spectatorWall.reset();
+
+    // Destroy the board layer and the cached score
+    destroyBoardLayer();
+    destroyScoreTexture();
+
+    // Release the textures, the cache destroys them
+    for (TextureHandle* handle : { &snakeHeadUpTexture, &snakeHeadDownTexture, &snakeHeadLeftTexture, &snakeHeadRightTexture,
+                                   &snakeBodyTexture, &snakeTailTexture, &foodTexture, &pooTexture, &fieldTexture,
+                                   &startScreenTexture, &endScreenTexture }) {
+        handle->reset();
     }
-    if (endScreenTexture != nullptr) {
-        SDL_DestroyTexture(endScreenTexture);
-        endScreenTexture = nullptr;
+    std::cout << "Texture cache: " << textures.hits() << " hits, " << textures.misses() << " misses, " << textures.evictions() << " evictions" << std::endl;
+    textures.clear();
+
+    if (frameTarget != nullptr) {
+        SDL_DestroyTexture(frameTarget);
+        frameTarget = nullptr;
     }
 
     // Destroy the renderer
@@ -308,35 +273,54 @@ void Game::closeSDL() {
 
 void Game::showMainMenu() {
     SDL_Event e;
-    bool menuActive = true;
+    bool redraw = true;
 
     // Play start screen music
     if (Mix_PlayingMusic() == 0) {
         Mix_PlayMusic(startScreenMusic, -1);
     }
 
-    while (menuActive) {
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
-        SDL_RenderClear(renderer);
-
-        // Draw the start screen
-        SDL_Rect startScreenRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
-        SDL_RenderCopy(renderer, startScreenTexture, NULL, &startScreenRect);
-
-        // Render the prompt text
-        SDL_Color textColor = { 255, 255, 255, 255 }; // White color
-        SDL_Surface* surfacePrompt = TTF_RenderText_Solid(font, "Press 'S' to Start, 'L' for Leaderboard", textColor);
-        SDL_Texture* texturePrompt = SDL_CreateTextureFromSurface(renderer, surfacePrompt);
-
-        SDL_Rect promptRect = { (WINDOW_WIDTH - surfacePrompt->w) / 2, (WINDOW_HEIGHT / 2) + 10, surfacePrompt->w, surfacePrompt->h };
-        SDL_RenderCopy(renderer, texturePrompt, NULL, &promptRect);
-
-        SDL_FreeSurface(surfacePrompt);
-        SDL_DestroyTexture(texturePrompt);
+    while (true) {
+        // Nothing on this screen moves, so it is only drawn again when something asks for it
+        if (redraw && windowVisible) {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
+            SDL_RenderClear(renderer);
+
+            // Draw the start screen
+            SDL_Rect startScreenRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
+            SDL_RenderCopy(renderer, startScreenTexture.get(), NULL, &startScreenRect);
+
+            // Render the prompt text
+            SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+            SDL_Surface* surfacePrompt = TTF_RenderText_Solid(font, "Press 'S' to Start, 'L' for Leaderboard", textColor);
+            SDL_Texture* texturePrompt = SDL_CreateTextureFromSurface(renderer, surfacePrompt);
+
+            SDL_Rect promptRect = { (WINDOW_WIDTH - surfacePrompt->w) / 2, (WINDOW_HEIGHT / 2) + 10, surfacePrompt->w, surfacePrompt->h };
+            SDL_RenderCopy(renderer, texturePrompt, NULL, &promptRect);
+
+            SDL_FreeSurface(surfacePrompt);
+            SDL_DestroyTexture(texturePrompt);
+
+            // Offer to continue a paused game
+            if (savedGameAvailable) {
+                SDL_Surface* surfaceContinue = TTF_RenderText_Solid(font, "Press 'C' to Continue", textColor);
+                SDL_Texture* textureContinue = SDL_CreateTextureFromSurface(renderer, surfaceContinue);
+                SDL_Rect continueRect = { (WINDOW_WIDTH - surfaceContinue->w) / 2, promptRect.y + promptRect.h + 10, surfaceContinue->w, surfaceContinue->h };
+                SDL_RenderCopy(renderer, textureContinue, NULL, &continueRect);
+                SDL_FreeSurface(surfaceContinue);
+                SDL_DestroyTexture(textureContinue);
+            }
 
-        SDL_RenderPresent(renderer);
+            SDL_RenderPresent(renderer);
+            redraw = false;
+        }
 
-        while (SDL_PollEvent(&e) != 0) {
+        // Sleep until something happens
+        if (!SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+            continue;
+        }
+        do {
+            redraw |= trackWindowEvent(e);
             if (e.type == SDL_QUIT) {
                 currentState = GAME_OVER;
                 gameRunning = false;
@@ -346,10 +330,18 @@ void Game::showMainMenu() {
                 switch (e.key.keysym.sym) {
                 case SDLK_s:
                     getPlayerName();
+                    if (!gameRunning) {
+                        return;
+                    }
                     if (!playerName.empty()) {
+                        startGame();
+                        return;
+                    }
+                    redraw = true;
+                    break;
+                case SDLK_c:
+                    if (savedGameAvailable && loadGame()) {
                         currentState = IN_GAME;
-                        resetGame();
-                        // Stop start screen music and play in-game music
                         Mix_HaltMusic();
                         Mix_PlayMusic(inGameMusic, -1);
                         return;
@@ -360,7 +352,7 @@ void Game::showMainMenu() {
                     return;
                 }
             }
-        }
+        } while (SDL_PollEvent(&e) != 0);
     }
 }
 
@@ -370,44 +362,54 @@ void Game::getPlayerName() {
     SDL_Event e;
 
     bool inputActive = true;
+    bool redraw = true;
     while (inputActive) {
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
-        SDL_RenderClear(renderer);
+        // Only draw again after the name changed or the window needs it
+        if (redraw && windowVisible) {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
+            SDL_RenderClear(renderer);
 
-        // Render the prompt text
-        SDL_Color textColor = { 255, 255, 255, 255 }; // White color
-        SDL_Surface* surfacePrompt = TTF_RenderText_Solid(font, "Enter your name: ", textColor);
+            // Render the prompt text
+            SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+            SDL_Surface* surfacePrompt = TTF_RenderText_Solid(font, "Enter your name: ", textColor);
 
-        SDL_Texture* texturePrompt = SDL_CreateTextureFromSurface(renderer, surfacePrompt);
+            SDL_Texture* texturePrompt = SDL_CreateTextureFromSurface(renderer, surfacePrompt);
 
-        SDL_Rect promptRect = { (WINDOW_WIDTH - surfacePrompt->w) / 2, 50, surfacePrompt->w, surfacePrompt->h };
-        SDL_RenderCopy(renderer, texturePrompt, NULL, &promptRect);
+            SDL_Rect promptRect = { (WINDOW_WIDTH - surfacePrompt->w) / 2, 50, surfacePrompt->w, surfacePrompt->h };
+            SDL_RenderCopy(renderer, texturePrompt, NULL, &promptRect);
 
-        SDL_FreeSurface(surfacePrompt);
-        SDL_DestroyTexture(texturePrompt);
+            SDL_FreeSurface(surfacePrompt);
+            SDL_DestroyTexture(texturePrompt);
 
-        // Render the current input text
-        SDL_Surface* surfaceInput = TTF_RenderText_Solid(font, playerName.c_str(), textColor);
-        if (!surfaceInput) {
-            std::cerr << "TTF_RenderText_Solid error: " << TTF_GetError() << std::endl;
-            break;
-        }
-        SDL_Texture* textureInput = SDL_CreateTextureFromSurface(renderer, surfaceInput);
-        if (!textureInput) {
-            std::cerr << "SDL_CreateTextureFromSurface error: " << SDL_GetError() << std::endl;
-            SDL_FreeSurface(surfaceInput);
-            break;
-        }
+            // Render the current input text
+            SDL_Surface* surfaceInput = TTF_RenderText_Solid(font, playerName.c_str(), textColor);
+            if (!surfaceInput) {
+                std::cerr << "TTF_RenderText_Solid error: " << TTF_GetError() << std::endl;
+                break;
+            }
+            SDL_Texture* textureInput = SDL_CreateTextureFromSurface(renderer, surfaceInput);
+            if (!textureInput) {
+                std::cerr << "SDL_CreateTextureFromSurface error: " << SDL_GetError() << std::endl;
+                SDL_FreeSurface(surfaceInput);
+                break;
+            }
 
-        SDL_Rect inputRect = { (WINDOW_WIDTH - surfacePrompt->w) / 2, 100, surfaceInput->w, surfaceInput->h };
-        SDL_RenderCopy(renderer, textureInput, NULL, &inputRect);
+            SDL_Rect inputRect = { promptRect.x, 100, surfaceInput->w, surfaceInput->h };
+            SDL_RenderCopy(renderer, textureInput, NULL, &inputRect);
 
-        SDL_FreeSurface(surfaceInput);
-        SDL_DestroyTexture(textureInput);
+            SDL_FreeSurface(surfaceInput);
+            SDL_DestroyTexture(textureInput);
 
-        SDL_RenderPresent(renderer);
+            SDL_RenderPresent(renderer);
+            redraw = false;
+        }
 
-        while (SDL_PollEvent(&e) != 0) {
+        // Sleep until something happens
+        if (!SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+            continue;
+        }
+        do {
+            redraw |= trackWindowEvent(e);
             if (e.type == SDL_QUIT) {
                 currentState = GAME_OVER;
                 gameRunning = false;
@@ -417,11 +419,13 @@ void Game::getPlayerName() {
             else if (e.type == SDL_TEXTINPUT) {
                 // Append the character to playerName
                 playerName += e.text.text;
+                redraw = true;
             }
             else if (e.type == SDL_KEYDOWN) {
                 if (e.key.keysym.sym == SDLK_BACKSPACE && playerName.length() > 0) {
                     // Handle backspace
                     playerName.pop_back();
+                    redraw = true;
                 }
                 else if (e.key.keysym.sym == SDLK_RETURN) {
                     // Enter key pressed, check if name is not empty
@@ -431,214 +435,741 @@ void Game::getPlayerName() {
                     }
                 }
             }
-        }
+        } while (inputActive && SDL_PollEvent(&e) != 0);
     }
 }
 
 void Game::showGameOverScreen() {
-    // Set the color and clear the screen
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
-    SDL_RenderClear(renderer);
-
-    // Draw the start screen
-    SDL_Rect endScreenRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
-    SDL_RenderCopy(renderer, endScreenTexture, NULL, &endScreenRect);
-
-    // Define text color
-    SDL_Color textColor = { 255, 255, 255, 255 }; // White color
-
-    // Render "Game Over" text
-    SDL_Surface* surfaceGameOver = TTF_RenderText_Solid(font, "Game Over", textColor);
-    SDL_Texture* textureGameOver = SDL_CreateTextureFromSurface(renderer, surfaceGameOver);
-    SDL_Rect gameOverRect = { (WINDOW_WIDTH - surfaceGameOver->w) / 2, (WINDOW_HEIGHT / 2) - 50, surfaceGameOver->w, surfaceGameOver->h };
-    SDL_RenderCopy(renderer, textureGameOver, NULL, &gameOverRect);
-
-    // Render "Press 'R' to Restart, 'Q' to Quit" text
-    SDL_Surface* surfaceRestart = TTF_RenderText_Solid(font, "Press 'R' to Restart, 'Q' to Quit", textColor);
-    SDL_Texture* textureRestart = SDL_CreateTextureFromSurface(renderer, surfaceRestart);
-    SDL_Rect restartRect = { (WINDOW_WIDTH - surfaceRestart->w) / 2, (WINDOW_HEIGHT / 2) + 10, surfaceRestart->w, surfaceRestart->h };
-    SDL_RenderCopy(renderer, textureRestart, NULL, &restartRect);
-
-    // Free surfaces and textures
-    SDL_FreeSurface(surfaceGameOver);
-    SDL_DestroyTexture(textureGameOver);
-    SDL_FreeSurface(surfaceRestart);
-    SDL_DestroyTexture(textureRestart);
-
-    // Save the score to the leaderboard
+    // Save the score to the leaderboard, once per game
     addScoreToLeaderboard(playerScore, playerName);
 
-    // Handle input
     SDL_Event e;
-    while (SDL_PollEvent(&e) != 0) {
-        if (e.type == SDL_QUIT) {
-            currentState = GAME_OVER;
-            gameRunning = false;
+    bool redraw = true;
+    while (true) {
+        if (redraw && windowVisible) {
+            // Set the color and clear the screen
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
+            SDL_RenderClear(renderer);
+
+            // Draw the start screen
+            SDL_Rect endScreenRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
+            SDL_RenderCopy(renderer, endScreenTexture.get(), NULL, &endScreenRect);
+
+            // Define text color
+            SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+
+            // Render "Game Over" text
+            SDL_Surface* surfaceGameOver = TTF_RenderText_Solid(font, "Game Over", textColor);
+            SDL_Texture* textureGameOver = SDL_CreateTextureFromSurface(renderer, surfaceGameOver);
+            SDL_Rect gameOverRect = { (WINDOW_WIDTH - surfaceGameOver->w) / 2, (WINDOW_HEIGHT / 2) - 50, surfaceGameOver->w, surfaceGameOver->h };
+            SDL_RenderCopy(renderer, textureGameOver, NULL, &gameOverRect);
+
+            // Render "Press 'R' to Restart, 'Q' to Quit" text
+            SDL_Surface* surfaceRestart = TTF_RenderText_Solid(font, "Press 'R' to Restart, 'Q' to Quit", textColor);
+            SDL_Texture* textureRestart = SDL_CreateTextureFromSurface(renderer, surfaceRestart);
+            SDL_Rect restartRect = { (WINDOW_WIDTH - surfaceRestart->w) / 2, (WINDOW_HEIGHT / 2) + 10, surfaceRestart->w, surfaceRestart->h };
+            SDL_RenderCopy(renderer, textureRestart, NULL, &restartRect);
+
+            // Free surfaces and textures
+            SDL_FreeSurface(surfaceGameOver);
+            SDL_DestroyTexture(textureGameOver);
+            SDL_FreeSurface(surfaceRestart);
+            SDL_DestroyTexture(textureRestart);
+
+            // Present the render
+            SDL_RenderPresent(renderer);
+            redraw = false;
         }
-        else if (e.type == SDL_KEYDOWN) {
-            switch (e.key.keysym.sym) {
-            case SDLK_r:
-                currentState = IN_GAME;
-                resetGame();
-                // Stop game over music and play in-game music
-                Mix_HaltMusic();
-                Mix_PlayMusic(inGameMusic, -1);
-                return;
-            case SDLK_q:
+
+        // Handle input, sleeping until there is some
+        if (!SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+            continue;
+        }
+        do {
+            redraw |= trackWindowEvent(e);
+            if (e.type == SDL_QUIT) {
+                currentState = GAME_OVER;
                 gameRunning = false;
                 return;
             }
-        }
+            else if (e.type == SDL_KEYDOWN) {
+                switch (e.key.keysym.sym) {
+                case SDLK_r:
+                    startGame();
+                    return;
+                case SDLK_q:
+                    gameRunning = false;
+                    return;
+                }
+            }
+        } while (SDL_PollEvent(&e) != 0);
     }
-
-   
-
-    // Present the render
-    SDL_RenderPresent(renderer);
-    SDL_Delay(100);
 }
 
 void Game::showLeaderboard() {
-    // Clear the previous render
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
-    SDL_RenderClear(renderer);
-
-    // Define text color
-    SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+    // Rows between the top margin and the help line at the bottom
+    SDL_Rect listArea = { 50, 50, WINDOW_WIDTH - 100, WINDOW_HEIGHT - 110 };
+    LeaderboardView view(renderer, font, leaderboard, listArea);
+    std::string rankInput; // Digits typed so far for jumping to a rank
 
-    // Render leaderboard text
-    int yOffset = 50;
-    for (size_t i = 0; i < leaderboard.size(); ++i) {
-        std::string entry = std::to_string(i + 1) + ". " + leaderboard[i].second + " - " + std::to_string(leaderboard[i].first);
-        SDL_Surface* surfaceEntry = TTF_RenderText_Solid(font, entry.c_str(), textColor);
-        SDL_Texture* textureEntry = SDL_CreateTextureFromSurface(renderer, surfaceEntry);
-
-        SDL_Rect entryRect = { 50, yOffset, surfaceEntry->w, surfaceEntry->h };
-        SDL_RenderCopy(renderer, textureEntry, NULL, &entryRect);
+    SDL_Event e;
+    bool redraw = true;
+    while (true) {
+        if (redraw && windowVisible) {
+            // Clear the previous render
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
+            SDL_RenderClear(renderer);
+
+            // Only the visible rows are drawn
+            view.render();
+
+            // Render the help line, or the rank being typed
+            if (rankInput.empty()) {
+                std::snprintf(textBuffer, sizeof(textBuffer), "M: My best   0-9: Rank   Esc: Back");
+            }
+            else {
+                std::snprintf(textBuffer, sizeof(textBuffer), "Go to rank: %s", rankInput.c_str());
+            }
+            SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+            SDL_Surface* surfaceHelp = TTF_RenderText_Solid(font, textBuffer, textColor);
+            if (surfaceHelp != nullptr) {
+                SDL_Texture* textureHelp = SDL_CreateTextureFromSurface(renderer, surfaceHelp);
+                SDL_Rect helpRect = { (WINDOW_WIDTH - surfaceHelp->w) / 2, WINDOW_HEIGHT - 45, surfaceHelp->w, surfaceHelp->h };
+                SDL_RenderCopy(renderer, textureHelp, NULL, &helpRect);
+                SDL_FreeSurface(surfaceHelp);
+                SDL_DestroyTexture(textureHelp);
+            }
 
-        SDL_FreeSurface(surfaceEntry);
-        SDL_DestroyTexture(textureEntry);
+            SDL_RenderPresent(renderer);
+            redraw = false;
+        }
 
-        yOffset += 30;
+        // Sleep until something happens
+        if (!SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+            continue;
+        }
+        do {
+            redraw |= trackWindowEvent(e);
+            if (e.type == SDL_RENDER_DEVICE_RESET) {
+                view.invalidate();
+            }
+            else if (e.type == SDL_QUIT) {
+                gameRunning = false;
+                return;
+            }
+            else if (e.type == SDL_MOUSEWHEEL) {
+                view.scrollBy(-e.wheel.y * 3);
+                redraw = true;
+            }
+            else if (e.type == SDL_KEYDOWN) {
+                int key = e.key.keysym.sym;
+                redraw = true;
+                switch (key) {
+                case SDLK_UP:       view.scrollBy(-1); break;
+                case SDLK_DOWN:     view.scrollBy(1); break;
+                case SDLK_PAGEUP:   view.scrollBy(-static_cast<long>(view.visibleRows())); break;
+                case SDLK_PAGEDOWN: view.scrollBy(static_cast<long>(view.visibleRows())); break;
+                case SDLK_HOME:     view.scrollToTop(); break;
+                case SDLK_END:      view.scrollToBottom(); break;
+                case SDLK_m:        view.jumpToPlayer(playerName); break;
+                case SDLK_RETURN:
+                case SDLK_KP_ENTER:
+                    if (!rankInput.empty()) {
+                        view.jumpToRank(std::stoul(rankInput));
+                        rankInput.clear();
+                    }
+                    break;
+                case SDLK_BACKSPACE:
+                    if (!rankInput.empty()) {
+                        rankInput.pop_back();
+                        break;
+                    }
+                    currentState = MAIN_MENU;
+                    return;
+                case SDLK_ESCAPE:
+                case SDLK_l:
+                    currentState = MAIN_MENU;
+                    return;
+                default:
+                    if (key >= SDLK_0 && key <= SDLK_9 && rankInput.size() < 9) {
+                        rankInput += static_cast<char>('0' + (key - SDLK_0));
+                    }
+                    break;
+                }
+            }
+        } while (SDL_PollEvent(&e) != 0);
     }
+}
 
-    SDL_RenderPresent(renderer);
-    SDL_Delay(3000); // Show for 3 seconds before returning to main menu
-    currentState = MAIN_MENU;
+void Game::startGame() {
+    // A world map replaces the board when one was loaded
+    if (world) {
+        currentState = IN_WORLD;
+        resetWorld();
+    }
+    else {
+        currentState = IN_GAME;
+        resetGame();
+    }
+    // Stop the current music and play in-game music
+    Mix_HaltMusic();
+    Mix_PlayMusic(inGameMusic, -1);
 }
 
 void Game::resetGame() {
-    delete board;
-    board = new GameBoard();
+    board->reset(); // Reuses the storage of the previous game
     playerScore = 0; // Reset score
     pooSpawned = false;
+
+    // Start every game from a freshly created layer, this also recovers from a device reset seen in the menus
+    destroyBoardLayer();
+    createBoardLayer();
+}
+
+bool Game::trackWindowEvent(const SDL_Event& e) {
+    if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+        return true;
+    }
+    if (e.type != SDL_WINDOWEVENT || options.headless) {
+        return false; // A headless window is never shown, it mustn't pause anything
+    }
+    switch (e.window.event) {
+    case SDL_WINDOWEVENT_HIDDEN:
+    case SDL_WINDOWEVENT_MINIMIZED:
+        windowVisible = false;
+        return false;
+    case SDL_WINDOWEVENT_SHOWN:
+    case SDL_WINDOWEVENT_RESTORED:
+    case SDL_WINDOWEVENT_MAXIMIZED:
+        windowVisible = true;
+        return true;
+    case SDL_WINDOWEVENT_FOCUS_LOST:
+        windowFocused = false;
+        return false;
+    case SDL_WINDOWEVENT_FOCUS_GAINED:
+        windowFocused = true;
+        return false;
+    case SDL_WINDOWEVENT_EXPOSED:
+    case SDL_WINDOWEVENT_SIZE_CHANGED:
+        return true;
+    }
+    return false;
 }
 
 void Game::handleEvents(SDL_Event& e) {
-    if (e.type == SDL_KEYDOWN) {
+    trackWindowEvent(e);
+    if (e.type == SDL_RENDER_TARGETS_RESET) {
+        // The layer contents are gone, redraw it completely
+        boardLayerValid = false;
+    }
+    else if (e.type == SDL_RENDER_DEVICE_RESET) {
+        // Every texture is gone, the cache reloads images on their next use
+        textures.invalidate();
+        destroyBoardLayer();
+        createBoardLayer();
+        destroyScoreTexture();
+    }
+    else if (e.type == SDL_WINDOWEVENT && (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED || e.window.event == SDL_WINDOWEVENT_EXPOSED)) {
+        boardLayerValid = false;
+    }
+    else if (e.type == SDL_KEYDOWN) {
         switch (e.key.keysym.sym) {
-        case SDLK_UP:     board->snake->setDirection(0);  break;
-        case SDLK_DOWN:   board->snake->setDirection(1); break;
-        case SDLK_LEFT:   board->snake->setDirection(2); break;
-        case SDLK_RIGHT:  board->snake->setDirection(3); break;
+        case SDLK_UP:     steer(0); break;
+        case SDLK_DOWN:   steer(1); break;
+        case SDLK_LEFT:   steer(2); break;
+        case SDLK_RIGHT:  steer(3); break;
+        case SDLK_p:
+            // The simulation may be a tick ahead of the screen: stop it and save its last tick,
+            // unless that tick already ended the game
+            if (stopSimulation()) {
+                endGame();
+                break;
+            }
+            // Pause to disk and go back to the menu
+            saveGame();
+            currentState = MAIN_MENU;
+            Mix_HaltMusic();
+            break;
         }
     }
 }
 
 void Game::update() {
-    board->snake->moveSnake(board->BOARD_WIDTH, board->BOARD_HEIGHT);
-    if (board->snake->body[0].x == board->food.x && board->snake->body[0].y == board->food.y) {
-        board->snake->growSnake(board->snake->body.back().x, board->snake->body.back().y);
-        board->generateFood();
-        playerScore += 10; // Increase score when food is eaten
+    // The rules live in GameBoard::step, shared with the threaded simulation
+    GameBoard::StepResult result = board->step();
+    if (result == GameBoard::StepResult::ATE_FOOD) {
+        playerScore = board->getScore();
         // Play ping sound
         Mix_PlayChannel(-1, pingSound, 0);
         if (playerScore >= 100) {
-            board->generatePoo();
             pooSpawned = true;
         }
     }
-    else if (board->snake->checkCollision() || board->snake->body[0].x == board->poo.x && board->snake->body[0].y == board->poo.y) {
-        // Play ping sound
-        Mix_PlayChannel(-1, dedSound, 0);
-        // Stop in-game music and play game over music
-        currentState = GAME_OVER;
-        SDL_Delay(1000);
-        Mix_HaltMusic();
-        Mix_PlayMusic(gameOverMusic, -1);
+    else if (result == GameBoard::StepResult::DIED) {
+        endGame();
     }
+
+#ifdef _DEBUG
+    // Debug builds check every tick that the incremental hash didn't drift from the state
+    if (board->hash() != board->computeHash()) {
+        std::cerr << "Board hash out of sync! Incremental " << std::hex << board->hash() << ", full " << board->computeHash() << std::dec << std::endl;
+    }
+#endif
+}
+
+void Game::endGame() {
+    // Play ping sound
+    Mix_PlayChannel(-1, dedSound, 0);
+    // Stop in-game music and play game over music
+    currentState = GAME_OVER;
+    SDL_Delay(1000);
+    Mix_HaltMusic();
+    Mix_PlayMusic(gameOverMusic, -1);
 }
 
 void Game::render() {
+    SDL_SetRenderTarget(renderer, frameTarget);
+
+    // Draw the board through the retained layer, or straight to the window if that is not possible
+    if (boardLayer == nullptr || !renderBoardLayer()) {
+        renderFullBoard();
+    }
+
+    // Render the current score
+    renderScore();
+
+    // Hand the finished frame to the recorder before it is presented
+    if (frameCapture.isActive()) {
+        frameCapture.captureFrame(renderer);
+    }
+
+    SDL_RenderPresent(renderer);
+
+    // Textures reloaded this frame may have pushed the cache over its budget
+    textures.trim();
+}
+
+void Game::renderScore() {
+    if (scoreTexture == nullptr || scoreTextureValue != playerScore) {
+        destroyScoreTexture();
+
+        std::snprintf(textBuffer, sizeof(textBuffer), "Score: %d", playerScore);
+        SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+        SDL_Surface* scoreSurface = TTF_RenderText_Solid(font, textBuffer, textColor);
+        if (scoreSurface == nullptr) {
+            return;
+        }
+        scoreTexture = SDL_CreateTextureFromSurface(renderer, scoreSurface);
+        scoreTextureWidth = scoreSurface->w;
+        scoreTextureHeight = scoreSurface->h;
+        scoreTextureValue = playerScore;
+        SDL_FreeSurface(scoreSurface);
+    }
+
+    SDL_Rect scoreRect = { 10, 10, scoreTextureWidth, scoreTextureHeight };
+    SDL_RenderCopy(renderer, scoreTexture, NULL, &scoreRect);
+}
+
+void Game::destroyScoreTexture() {
+    if (scoreTexture != nullptr) {
+        SDL_DestroyTexture(scoreTexture);
+        scoreTexture = nullptr;
+    }
+    scoreTextureValue = -1;
+}
+
+bool Game::createBoardLayer() {
+    if (!SDL_RenderTargetSupported(renderer)) {
+        std::cerr << "Warning: Render targets not supported, the board is redrawn every frame!" << std::endl;
+        return false;
+    }
+
+    boardLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, board->BOARD_WIDTH, board->BOARD_HEIGHT);
+    if (boardLayer == nullptr) {
+        std::cerr << "Failed to create board layer! SDL Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_SetTextureBlendMode(boardLayer, SDL_BLENDMODE_NONE);
+
+    // The field is stretched over the board, remember its size to cut out the piece under a single cell
+    SDL_QueryTexture(fieldTexture.get(), NULL, NULL, &fieldTextureWidth, &fieldTextureHeight);
+
+    size_t cellCount = (board->BOARD_WIDTH / board->FOOD_SEGMENT_SIZE) * (board->BOARD_HEIGHT / board->FOOD_SEGMENT_SIZE);
+    drawnCells.assign(cellCount, nullptr);
+    frameCells.assign(cellCount, nullptr);
+    boardLayerValid = false;
+    return true;
+}
+
+void Game::destroyBoardLayer() {
+    if (boardLayer != nullptr) {
+        SDL_DestroyTexture(boardLayer);
+        boardLayer = nullptr;
+    }
+    boardLayerValid = false;
+}
+
+bool Game::renderBoardLayer() {
+    if (SDL_SetRenderTarget(renderer, boardLayer) != 0) {
+        std::cerr << "Failed to select board layer! SDL Error: " << SDL_GetError() << std::endl;
+        destroyBoardLayer();
+        return false;
+    }
+
+    collectBoardCells();
+
+    if (textures.evictions() != seenEvictions) {
+        seenEvictions = textures.evictions();
+        boardLayerValid = false;
+    }
+    if (!boardLayerValid) {
+        // Full redraw, start from the bare field and let the loop below put every sprite back
+        SDL_RenderCopy(renderer, fieldTexture.get(), NULL, NULL);
+        std::fill(drawnCells.begin(), drawnCells.end(), nullptr);
+        boardLayerValid = true;
+    }
+
+    // Only touch the cells whose sprite differs from what the layer already shows
+    for (size_t cell = 0; cell < frameCells.size(); ++cell) {
+        if (frameCells[cell] != drawnCells[cell]) {
+            drawBoardCell(static_cast<int>(cell), frameCells[cell]);
+            drawnCells[cell] = frameCells[cell];
+        }
+    }
+
+    SDL_SetRenderTarget(renderer, frameTarget);
+    SDL_RenderCopy(renderer, boardLayer, NULL, NULL);
+    return true;
+}
+
+void Game::renderFullBoard() {
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
     SDL_RenderClear(renderer);
 
     // Draw the field
     SDL_Rect fieldRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
-    SDL_RenderCopy(renderer, fieldTexture, NULL, &fieldRect);
+    SDL_RenderCopy(renderer, fieldTexture.get(), NULL, &fieldRect);
 
     // Draw food
     SDL_Rect foodRect = { board->food.x, board->food.y, board->FOOD_SEGMENT_SIZE, board->FOOD_SEGMENT_SIZE };
-    SDL_RenderCopy(renderer, foodTexture, NULL, &foodRect);
+    SDL_RenderCopy(renderer, foodTexture.get(), NULL, &foodRect);
 
     // Draw poo if spawned
     if (pooSpawned) {
         SDL_Rect pooRect = { board->poo.x, board->poo.y, board->FOOD_SEGMENT_SIZE, board->FOOD_SEGMENT_SIZE };
-        SDL_RenderCopy(renderer, pooTexture, NULL, &pooRect);
+        SDL_RenderCopy(renderer, pooTexture.get(), NULL, &pooRect);
     }
 
-    // Draw snake
+    // Draw snake, looking the sprites up once rather than per segment
+    SDL_Texture* head = headTexture(board->snake->direction);
+    SDL_Texture* tail = snakeTailTexture.get();
+    SDL_Texture* body = snakeBodyTexture.get();
     for (size_t i = 0; i < board->snake->body.size(); ++i) {
         SDL_Rect rect = { board->snake->body[i].x, board->snake->body[i].y, board->snake->BODY_SEGMENT_SIZE, board->snake->BODY_SEGMENT_SIZE };
         if (i == 0) {
             // Draw the head
-            SDL_Texture* headTexture = nullptr;
-            switch (board->snake->direction) {
-            case Snake::Direction::UP: headTexture = snakeHeadUpTexture; break;
-            case Snake::Direction::DOWN: headTexture = snakeHeadDownTexture; break;
-            case Snake::Direction::LEFT: headTexture = snakeHeadLeftTexture; break;
-            case Snake::Direction::RIGHT: headTexture = snakeHeadRightTexture; break;
-            }
-            SDL_RenderCopy(renderer, headTexture, NULL, &rect);
+            SDL_RenderCopy(renderer, head, NULL, &rect);
         }
         else if (i == board->snake->body.size() - 1) {
             // Draw the tail
-            SDL_RenderCopy(renderer, snakeTailTexture, NULL, &rect);
+            SDL_RenderCopy(renderer, tail, NULL, &rect);
         }
         else {
             // Draw the body
-            SDL_RenderCopy(renderer, snakeBodyTexture, NULL, &rect);
+            SDL_RenderCopy(renderer, body, NULL, &rect);
         }
     }
+}
 
-    // Render the current score
-    std::string scoreText = "Score: " + std::to_string(playerScore);
-    SDL_Color textColor = { 255, 255, 255, 255 }; // White color
-    SDL_Surface* scoreSurface = TTF_RenderText_Solid(font, scoreText.c_str(), textColor);
-    SDL_Texture* scoreTexture = SDL_CreateTextureFromSurface(renderer, scoreSurface);
-    SDL_Rect scoreRect = { 10, 10, scoreSurface->w, scoreSurface->h };
-    SDL_RenderCopy(renderer, scoreTexture, NULL, &scoreRect);
+SDL_Texture* Game::headTexture(Snake::Direction direction) {
+    switch (direction) {
+    case Snake::Direction::UP: return snakeHeadUpTexture.get();
+    case Snake::Direction::DOWN: return snakeHeadDownTexture.get();
+    case Snake::Direction::LEFT: return snakeHeadLeftTexture.get();
+    case Snake::Direction::RIGHT: return snakeHeadRightTexture.get();
+    }
+    return nullptr;
+}
 
-    SDL_FreeSurface(scoreSurface);
-    SDL_DestroyTexture(scoreTexture);
+void Game::collectBoardCells() {
+    const int cellSize = board->FOOD_SEGMENT_SIZE;
+    const int columns = board->BOARD_WIDTH / cellSize;
+    const int rows = board->BOARD_HEIGHT / cellSize;
+    auto setCell = [&](int x, int y, SDL_Texture* sprite) {
+        int column = x / cellSize;
+        int row = y / cellSize;
+        if (x >= 0 && y >= 0 && column < columns && row < rows) {
+            frameCells[row * columns + column] = sprite;
+        }
+    };
 
-    SDL_RenderPresent(renderer);
+    std::fill(frameCells.begin(), frameCells.end(), nullptr);
+
+    // Same order as renderFullBoard, so whatever is drawn last wins a shared cell
+    setCell(board->food.x, board->food.y, foodTexture.get());
+    if (pooSpawned) {
+        setCell(board->poo.x, board->poo.y, pooTexture.get());
+    }
+    SDL_Texture* head = headTexture(board->snake->direction);
+    SDL_Texture* tail = snakeTailTexture.get();
+    SDL_Texture* bodySprite = snakeBodyTexture.get();
+    const std::vector<Snake::BodySegment>& body = board->snake->body;
+    for (size_t i = 0; i < body.size(); ++i) {
+        SDL_Texture* sprite = bodySprite;
+        if (i == 0) {
+            sprite = head;
+        }
+        else if (i == body.size() - 1) {
+            sprite = tail;
+        }
+        setCell(body[i].x, body[i].y, sprite);
+    }
+}
+
+void Game::drawBoardCell(int cell, SDL_Texture* sprite) {
+    const int cellSize = board->FOOD_SEGMENT_SIZE;
+    const int columns = board->BOARD_WIDTH / cellSize;
+    const int rows = board->BOARD_HEIGHT / cellSize;
+    int column = cell % columns;
+    int row = cell / columns;
+
+    // Restore the piece of field under the cell, then put the sprite on top of it
+    SDL_Rect fieldSrc = {
+        column * fieldTextureWidth / columns,
+        row * fieldTextureHeight / rows,
+        (column + 1) * fieldTextureWidth / columns - column * fieldTextureWidth / columns,
+        (row + 1) * fieldTextureHeight / rows - row * fieldTextureHeight / rows
+    };
+    SDL_Rect cellRect = { column * cellSize, row * cellSize, cellSize, cellSize };
+    SDL_RenderCopy(renderer, fieldTexture.get(), &fieldSrc, &cellRect);
+    if (sprite != nullptr) {
+        SDL_RenderCopy(renderer, sprite, NULL, &cellRect);
+    }
 }
 
 void Game::mainLoop() {
     SDL_Event e;
+
+    // Hidden or in the background, the game is paused: block until the window is back instead of ticking
+    if (!windowVisible || !windowFocused) {
+        Mix_PauseMusic();
+        while (gameRunning && currentState == IN_GAME && (!windowVisible || !windowFocused)) {
+            if (SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+                if (e.type == SDL_QUIT) {
+                    gameRunning = false;
+                }
+                handleEvents(e);
+            }
+        }
+        Mix_ResumeMusic();
+        boardLayerValid = false; // The window contents may be stale after being hidden
+        return;
+    }
     while (SDL_PollEvent(&e) != 0) {
         if (e.type == SDL_QUIT) {
             gameRunning = false;
         }
         handleEvents(e);
     }
+    if (currentState != IN_GAME) {
+        return; // Paused from the keyboard
+    }
+    if (options.threadedSim) {
+        threadedLoop();
+        return;
+    }
 
+    if (options.headless) {
+        autopilot();
+    }
+
+    size_t allocationsBefore = AllocationTracker::allocations();
     update();
+    size_t allocationsAfterTick = AllocationTracker::allocations();
     render();
+    size_t allocationsAfterFrame = AllocationTracker::allocations();
+
+    // In steady state neither the tick nor the frame may touch the heap
+    if (options.trackAllocations) {
+        size_t tickAllocations = allocationsAfterTick - allocationsBefore;
+        size_t frameAllocations = allocationsAfterFrame - allocationsAfterTick;
+        DEBUG_MSG("Allocations: tick " << tickAllocations << ", frame " << frameAllocations);
+        if (tickAllocations != 0 || frameAllocations != 0) {
+            std::cerr << "Steady state allocated on the heap! Tick: " << tickAllocations << ", frame: " << frameAllocations << std::endl;
+            std::abort();
+        }
+    }
+
     SDL_Delay(100); // Adjust to change the game speed
 }
 
+void Game::steer(int dir) {
+    if (simulation) {
+        simulation->steer(dir); // Applied on the next tick of the simulation thread
+    }
+    else {
+        board->snake->setDirection(dir);
+    }
+}
+
+void Game::autopilot() {
+    // Head for the food, x first. Reversing is ignored by setDirection, so a blocked turn just goes on straight
+    const Snake::BodySegment& head = board->snake->body[0];
+    if (board->food.x > head.x) steer(3);
+    else if (board->food.x < head.x) steer(2);
+    else if (board->food.y > head.y) steer(1);
+    else steer(0);
+}
+
+void Game::threadedLoop() {
+    // The simulation starts from the board as it is now: a new game, a loaded save or a resumed pause
+    simulation = std::make_unique<Simulation>(*board, playerScore, pooSpawned);
+    foodSeen = 0;
+    framesDrawn = 0;
+
+    SDL_Event e;
+    while (gameRunning && currentState == IN_GAME && windowVisible && windowFocused) {
+        while (SDL_PollEvent(&e) != 0) {
+            if (e.type == SDL_QUIT) {
+                gameRunning = false;
+            }
+            handleEvents(e);
+        }
+        if (!gameRunning || currentState != IN_GAME) {
+            break;
+        }
+
+        // Only a new tick changes the picture
+        if (!simulation->pollFrame()) {
+            SDL_Delay(1);
+            continue;
+        }
+        applySimFrame();
+        if (options.headless) {
+            autopilot();
+        }
+
+        size_t allocationsBefore = AllocationTracker::allocations();
+        render();
+        ++framesDrawn;
+        if (options.trackAllocations && AllocationTracker::allocations() != allocationsBefore) {
+            std::cerr << "Steady state allocated on the heap! Frame: " << AllocationTracker::allocations() - allocationsBefore << std::endl;
+            std::abort();
+        }
+
+        if (simulation->frame().gameOver) {
+            endGame();
+        }
+    }
+    stopSimulation();
+}
+
+void Game::applySimFrame() {
+    const SimFrame& frame = simulation->frame();
+    board->restoreSnapshot(frame.board);
+    board->setScore(frame.score);
+    playerScore = frame.score;
+    pooSpawned = frame.pooSpawned;
+    if (frame.foodEaten != foodSeen) {
+        foodSeen = frame.foodEaten;
+        Mix_PlayChannel(-1, pingSound, 0);
+    }
+
+#ifdef _DEBUG
+    if (board->hash() != frame.hash) {
+        std::cerr << "Board hash differs from the simulation! Tick " << frame.tick << std::endl;
+    }
+#endif
+}
+
+bool Game::stopSimulation() {
+    if (!simulation) {
+        return false;
+    }
+    simulation->stop();
+
+    // Keep the last tick, a paused game resumes from it
+    if (simulation->pollFrame()) {
+        applySimFrame();
+    }
+    std::cout << "Simulation: " << simulation->ticks() << " ticks, " << framesDrawn << " frames drawn, tick jitter mean "
+              << simulation->meanJitterMs() << " ms, max " << simulation->maxJitterMs() << " ms" << std::endl;
+    bool gameOver = simulation->frame().gameOver;
+    simulation.reset();
+    return gameOver;
+}
+
+bool Game::buildSpectatorAtlas() {
+    SDL_Texture* const sprites[SpectatorWall::WHITE] = {
+        snakeHeadUpTexture.get(), snakeHeadDownTexture.get(), snakeHeadLeftTexture.get(), snakeHeadRightTexture.get(),
+        snakeBodyTexture.get(), foodTexture.get(), pooTexture.get(), fieldTexture.get()
+    };
+    return spectatorWall->buildAtlas(sprites);
+}
+
+void Game::spectatorLoop() {
+    if (!spectatorWall) {
+        spectatorWall = std::make_unique<SpectatorWall>(renderer, options.spectateBoards, WINDOW_WIDTH, WINDOW_HEIGHT);
+        if (!buildSpectatorAtlas()) {
+            std::cerr << "Warning: No sprite atlas, boards are drawn as solid cells only!" << std::endl;
+        }
+    }
+
+    Uint32 fpsStart = SDL_GetTicks();
+    int frames = 0;
+    SDL_Event e;
+    while (gameRunning) {
+        // Same idle rules as the game: nothing is simulated or drawn while hidden
+        bool haveEvent = (windowVisible && windowFocused) ? SDL_PollEvent(&e) != 0 : SDL_WaitEventTimeout(&e, IDLE_WAIT_MS) != 0;
+        while (haveEvent) {
+            trackWindowEvent(e);
+            if (e.type == SDL_QUIT) {
+                gameRunning = false;
+            }
+            else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                if (e.type == SDL_RENDER_DEVICE_RESET) {
+                    textures.invalidate();
+                }
+                buildSpectatorAtlas();
+            }
+            else if (e.type == SDL_MOUSEWHEEL) {
+                spectatorWall->zoomBy(e.wheel.y);
+            }
+            else if (e.type == SDL_KEYDOWN) {
+                if (e.key.keysym.sym == SDLK_ESCAPE || e.key.keysym.sym == SDLK_q) {
+                    gameRunning = false;
+                }
+                spectatorWall->handleKey(e.key.keysym.sym);
+            }
+            haveEvent = SDL_PollEvent(&e) != 0;
+        }
+        if (!gameRunning || !windowVisible || !windowFocused) {
+            continue;
+        }
+
+        spectatorWall->update(SDL_GetTicks());
+
+        SDL_SetRenderTarget(renderer, frameTarget);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
+        SDL_RenderClear(renderer);
+        spectatorWall->render();
+        if (frameCapture.isActive()) {
+            frameCapture.captureFrame(renderer);
+        }
+        SDL_RenderPresent(renderer); // Paced by vsync
+
+        // Frame rate in the title, once a second
+        ++frames;
+        Uint32 now = SDL_GetTicks();
+        if (now - fpsStart >= 1000) {
+            std::snprintf(textBuffer, sizeof(textBuffer), "SNEJK - %d boards - %.1f fps", options.spectateBoards, frames * 1000.0 / (now - fpsStart));
+            SDL_SetWindowTitle(window, textBuffer);
+            fpsStart = now;
+            frames = 0;
+        }
+    }
+}
+
 void Game::run() {
     while (gameRunning) {
         switch (currentState) {
@@ -649,11 +1180,21 @@ void Game::run() {
             mainLoop();
             break;
         case GAME_OVER:
+            if (options.headless) {
+                gameRunning = false; // Nobody could leave the game over screen, the run is finished
+                break;
+            }
             showGameOverScreen();
             break;
         case LEADERBOARD:
             showLeaderboard();
             break;
+        case SPECTATOR:
+            spectatorLoop();
+            break;
+        case IN_WORLD:
+            worldLoop();
+            break;
         }
     }
 }
@@ -664,10 +1205,16 @@ void Game::loadLeaderboard() {
         json j;
         file >> j;
         leaderboard.clear();
+        leaderboard.reserve(j.size());
         for (const auto& entry : j) {
             leaderboard.push_back({ entry["score"], entry["name"] });
         }
         file.close();
+
+        // The file may have been edited by hand, keep the best scores first
+        std::stable_sort(leaderboard.begin(), leaderboard.end(), [](const std::pair<int, std::string>& a, const std::pair<int, std::string>& b) {
+            return a.first > b.first;
+            });
     }
 }
 
@@ -684,23 +1231,275 @@ void Game::saveLeaderboard() {
 }
 
 void Game::addScoreToLeaderboard(int score, const std::string& name) {
-    // Create a temporary vector to hold the scores including the new one
-    std::vector<std::pair<int, std::string>> tempLeaderboard = leaderboard;
-    tempLeaderboard.push_back({ score, name });
-
-    // Sort the temporary leaderboard
-    std::sort(tempLeaderboard.begin(), tempLeaderboard.end(), [](const std::pair<int, std::string>& a, const std::pair<int, std::string>& b) {
-        return a.first > b.first;
+    // The leaderboard is kept sorted, so the new score only has to be inserted at its place (after equal scores)
+    auto position = std::upper_bound(leaderboard.begin(), leaderboard.end(), score, [](int value, const std::pair<int, std::string>& entry) {
+        return value > entry.first;
         });
+    leaderboard.insert(position, { score, name });
 
-    // Keep only the top 10 scores
-    if (tempLeaderboard.size() > 10) {
-        tempLeaderboard.resize(10);
+    // Keep only the best scores
+    if (leaderboard.size() > MAX_LEADERBOARD_ENTRIES) {
+        leaderboard.resize(MAX_LEADERBOARD_ENTRIES);
     }
 
-    // Update the actual leaderboard
-    leaderboard = tempLeaderboard;
-
     saveLeaderboard();
 }
 
+void Game::saveGame() {
+    SavedGame saved = {};
+    std::memcpy(saved.magic, "SNSV", 4);
+    saved.version = SAVE_VERSION;
+    saved.score = playerScore;
+    std::strncpy(saved.playerName, playerName.c_str(), sizeof(saved.playerName) - 1);
+    board->saveSnapshot(saved.board);
+
+    std::ofstream file(SAVE_FILE, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(&saved), sizeof(saved))) {
+        std::cerr << "Failed to save the game!" << std::endl;
+        return;
+    }
+    savedGameAvailable = true;
+}
+
+bool Game::loadGame() {
+    SavedGame saved;
+    std::ifstream file(SAVE_FILE, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&saved), sizeof(saved)) ||
+        std::memcmp(saved.magic, "SNSV", 4) != 0 || saved.version != SAVE_VERSION ||
+        !saved.board.isValid()) {
+        std::cerr << "Failed to load the saved game!" << std::endl;
+        return false;
+    }
+    file.close();
+
+    board->restoreSnapshot(saved.board);
+    playerScore = saved.score;
+    board->setScore(playerScore);
+    saved.playerName[sizeof(saved.playerName) - 1] = '\0';
+    playerName = saved.playerName;
+    pooSpawned = saved.board.pooCell >= 0;
+    boardLayerValid = false;
+
+    // A saved game is resumed once
+    std::remove(SAVE_FILE);
+    savedGameAvailable = false;
+    return true;
+}
+
+// World positions are turned into pixels with int math
+static_assert(ChunkedWorld::MAX_SIZE <= INT_MAX / Snake::BODY_SEGMENT_SIZE, "World pixel coordinates would overflow");
+
+bool Game::loadWorld() {
+    world = std::make_unique<ChunkedWorld>(options.worldSize, options.worldSize);
+    if (std::ifstream(options.worldPath).good()) {
+        // An existing file that doesn't open as a map is never overwritten, it may be someone's map in another version
+        if (!world->openMap(options.worldPath)) {
+            std::cerr << "Failed to open world map " << options.worldPath << "!" << std::endl;
+            world.reset();
+            return false;
+        }
+    }
+    else {
+        // No map yet, generate one with walls scattered around the start and write it out
+        std::srand(static_cast<unsigned>(std::time(nullptr)));
+        int centerX = world->width() / 2;
+        int centerY = world->height() / 2;
+        for (int i = 0; i < 2000; ++i) {
+            int x = centerX + std::rand() % 1024 - 512;
+            int y = centerY + std::rand() % 1024 - 512;
+            bool horizontal = std::rand() % 2 == 0;
+            for (int j = 0; j < 6; ++j) {
+                world->set(horizontal ? x + j : x, horizontal ? y : y + j, ChunkedWorld::WALL);
+            }
+        }
+        if (!world->saveMap(options.worldPath) || !world->openMap(options.worldPath)) {
+            world.reset();
+            return false;
+        }
+    }
+
+    camera.columns = WINDOW_WIDTH / Snake::BODY_SEGMENT_SIZE;
+    camera.rows = WINDOW_HEIGHT / Snake::BODY_SEGMENT_SIZE;
+    return true;
+}
+
+void Game::resetWorld() {
+    // Take the leftovers of the last run off the map
+    if (worldFoodX >= 0) {
+        world->set(worldFoodX, worldFoodY, ChunkedWorld::EMPTY);
+        worldFoodX = worldFoodY = -1;
+    }
+    if (worldPooX >= 0) {
+        world->set(worldPooX, worldPooY, ChunkedWorld::EMPTY);
+        worldPooX = worldPooY = -1;
+    }
+
+    // Start in the middle of the world with a few free cells ahead
+    const int cell = Snake::BODY_SEGMENT_SIZE;
+    int startX = world->width() / 2;
+    int startY = world->height() / 2;
+    for (int i = 0; i < 4; ++i) {
+        world->set(startX + i, startY, ChunkedWorld::EMPTY);
+    }
+    if (!worldSnake) {
+        worldSnake = std::make_unique<Snake>(startX * cell, startY * cell);
+    }
+    else {
+        worldSnake->reset(startX * cell, startY * cell);
+    }
+    camera.follow(startX, startY, world->width(), world->height());
+    spawnWorldItem(ChunkedWorld::FOOD, worldFoodX, worldFoodY);
+
+    playerScore = 0;
+}
+
+bool Game::spawnWorldItem(uint8_t item, int& x, int& y) {
+    // Somewhere on screen, so there is always something to go for
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int candidateX = (camera.x + std::rand() % camera.columns) % world->width();
+        int candidateY = (camera.y + std::rand() % camera.rows) % world->height();
+        const Snake::BodySegment& head = worldSnake->body[0];
+        if (world->get(candidateX, candidateY) == ChunkedWorld::EMPTY &&
+            !(candidateX * Snake::BODY_SEGMENT_SIZE == head.x && candidateY * Snake::BODY_SEGMENT_SIZE == head.y)) {
+            world->set(candidateX, candidateY, item);
+            x = candidateX;
+            y = candidateY;
+            return true;
+        }
+    }
+    x = y = -1;
+    return false;
+}
+
+void Game::handleWorldEvent(SDL_Event& e) {
+    trackWindowEvent(e);
+    if (e.type == SDL_QUIT) {
+        gameRunning = false;
+    }
+    else if (e.type == SDL_RENDER_DEVICE_RESET) {
+        textures.invalidate();
+        destroyScoreTexture();
+    }
+    else if (e.type == SDL_KEYDOWN) {
+        switch (e.key.keysym.sym) {
+        case SDLK_UP:     worldSnake->setDirection(0); break;
+        case SDLK_DOWN:   worldSnake->setDirection(1); break;
+        case SDLK_LEFT:   worldSnake->setDirection(2); break;
+        case SDLK_RIGHT:  worldSnake->setDirection(3); break;
+        }
+    }
+}
+
+void Game::worldLoop() {
+    SDL_Event e;
+
+    // Paused while hidden or in the background, same as the board game
+    while (gameRunning && (!windowVisible || !windowFocused)) {
+        if (SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+            handleWorldEvent(e);
+        }
+    }
+
+    while (SDL_PollEvent(&e) != 0) {
+        handleWorldEvent(e);
+    }
+
+    updateWorld();
+    if (currentState == IN_WORLD) {
+        renderWorld();
+    }
+    SDL_Delay(100); // Adjust to change the game speed
+}
+
+void Game::updateWorld() {
+    const int cell = Snake::BODY_SEGMENT_SIZE;
+    worldSnake->moveSnake(world->width() * cell, world->height() * cell);
+    int headX = worldSnake->body[0].x / cell;
+    int headY = worldSnake->body[0].y / cell;
+    camera.follow(headX, headY, world->width(), world->height());
+
+    uint8_t item = world->get(headX, headY);
+    if (item == ChunkedWorld::FOOD) {
+        world->set(headX, headY, ChunkedWorld::EMPTY);
+        worldSnake->growSnake(worldSnake->body.back().x, worldSnake->body.back().y);
+        spawnWorldItem(ChunkedWorld::FOOD, worldFoodX, worldFoodY);
+        playerScore += 10; // Increase score when food is eaten
+        // Play ping sound
+        Mix_PlayChannel(-1, pingSound, 0);
+        if (playerScore >= 100) {
+            // The poo moves to a new place, like on the board
+            if (worldPooX >= 0) {
+                world->set(worldPooX, worldPooY, ChunkedWorld::EMPTY);
+            }
+            spawnWorldItem(ChunkedWorld::POO, worldPooX, worldPooY);
+        }
+    }
+    else if (worldSnake->checkCollision() || item == ChunkedWorld::POO || item == ChunkedWorld::WALL) {
+        // Play ded sound
+        Mix_PlayChannel(-1, dedSound, 0);
+        // Stop in-game music and play game over music
+        currentState = GAME_OVER;
+        SDL_Delay(1000);
+        Mix_HaltMusic();
+        Mix_PlayMusic(gameOverMusic, -1);
+    }
+}
+
+void Game::renderWorld() {
+    const int cell = Snake::BODY_SEGMENT_SIZE;
+    const int width = world->width();
+    const int height = world->height();
+
+    SDL_SetRenderTarget(renderer, frameTarget);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
+    SDL_RenderClear(renderer);
+    SDL_Rect fieldRect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
+    SDL_RenderCopy(renderer, fieldTexture.get(), NULL, &fieldRect);
+
+    // Only the cells under the camera are looked at, so only the chunks on screen are paged in
+    SDL_Texture* food = foodTexture.get();
+    SDL_Texture* poo = pooTexture.get();
+    SDL_SetRenderDrawColor(renderer, 70, 70, 70, 255); // Walls
+    for (int row = 0; row < camera.rows; ++row) {
+        int y = (camera.y + row) % height;
+        for (int column = 0; column < camera.columns; ++column) {
+            uint8_t item = world->get((camera.x + column) % width, y);
+            if (item == ChunkedWorld::EMPTY) {
+                continue;
+            }
+            SDL_Rect rect = { column * cell, row * cell, cell, cell };
+            if (item == ChunkedWorld::FOOD) {
+                SDL_RenderCopy(renderer, food, NULL, &rect);
+            }
+            else if (item == ChunkedWorld::POO) {
+                SDL_RenderCopy(renderer, poo, NULL, &rect);
+            }
+            else {
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+
+    // Snake segments relative to the camera, skipping the ones off screen
+    SDL_Texture* head = headTexture(worldSnake->direction);
+    SDL_Texture* tail = snakeTailTexture.get();
+    SDL_Texture* body = snakeBodyTexture.get();
+    const std::vector<Snake::BodySegment>& segments = worldSnake->body;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        int column = ((segments[i].x / cell - camera.x) % width + width) % width;
+        int row = ((segments[i].y / cell - camera.y) % height + height) % height;
+        if (column >= camera.columns || row >= camera.rows) {
+            continue;
+        }
+        SDL_Rect rect = { column * cell, row * cell, cell, cell };
+        SDL_Texture* sprite = i == 0 ? head : (i == segments.size() - 1 ? tail : body);
+        SDL_RenderCopy(renderer, sprite, NULL, &rect);
+    }
+
+    renderScore();
+    if (frameCapture.isActive()) {
+        frameCapture.captureFrame(renderer);
+    }
+    SDL_RenderPresent(renderer);
+    textures.trim();
+}
@@ -11,6 +11,25 @@
 #include <algorithm>
 #include <SDL_mixer.h>
 #include "GameBoard.h"
+#include "FrameCapture.h"
+#include "TextureCache.h"
+#include "SpectatorWall.h"
+#include "ChunkedWorld.h"
+#include "Simulation.h"
+
+// Settings picked on the command line
+struct GameOptions {
+    std::string captureDirectory; // Empty disables frame capture
+    bool capturePng = false;      // PNG sequence instead of one raw RGBA file
+    bool headless = false;        // Hidden window, frames are rendered to an offscreen target. Nobody can press a key,
+                                  // so a bot plays one game on the board (or use --spectate) and the program exits at game over
+    bool trackAllocations = false; // Fail when a tick or frame allocates on the heap (needs TRACK_ALLOCATIONS)
+    size_t textureBudgetMB = 256;  // Video memory the texture cache may fill before evicting
+    int spectateBoards = 0;        // Watch this many bot games instead of playing, 0 to play
+    std::string worldPath;         // Play on a large chunked world map instead of the board, empty to play the board
+    int worldSize = 100000;        // Cells per side when a new world map is generated
+    bool threadedSim = false;      // Tick the game on its own thread, the main thread only forwards input and draws
+};
 
 /* Short desc.
 Long desc.
@@ -18,43 +37,83 @@ Long desc.
 return _*/
 class Game {
 public:
-    Game();
+    Game(const GameOptions& options = GameOptions());
     ~Game();
     void run();
 
 private:
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
+    SDL_Texture* frameTarget = nullptr; // Offscreen target for headless runs, nullptr draws to the window
+    GameOptions options;
+    FrameCapture frameCapture;
     const int WINDOW_WIDTH = 600;
     const int WINDOW_HEIGHT = 600;
     enum GameState {
         MAIN_MENU,
         IN_GAME,
         GAME_OVER,
-        LEADERBOARD
+        LEADERBOARD,
+        SPECTATOR,
+        IN_WORLD
     };
     GameState currentState;
     bool gameRunning;
     bool pooSpawned = false;
+    bool savedGameAvailable = false; // A paused game is waiting in savegame.bin
+    bool windowVisible = true;  // False while hidden or minimized, nothing is drawn then
+    bool windowFocused = true;  // The game is paused while the window is in the background
+    static const int IDLE_WAIT_MS = 500; // Longest sleep of the event driven screens
+
+    GameBoard* board; // With a threaded simulation this is the render side copy of the latest frame
+    std::unique_ptr<Simulation> simulation;
+    uint32_t framesDrawn = 0;
+    uint32_t foodSeen = 0; // Foods of the running simulation that already played their sound
+    std::unique_ptr<SpectatorWall> spectatorWall;
 
-    GameBoard* board;
+    // World mode, only set up when a world map was given
+    std::unique_ptr<ChunkedWorld> world;
+    std::unique_ptr<Snake> worldSnake;
+    WorldCamera camera;
+    int worldFoodX = -1; // Cells, -1 when there is none
+    int worldFoodY = -1;
+    int worldPooX = -1;
+    int worldPooY = -1;
     TTF_Font* font;
 
     std::string playerName;
     int playerScore;
-    std::vector<std::pair<int, std::string>> leaderboard;
+    std::vector<std::pair<int, std::string>> leaderboard; // Best score first
+    static const size_t MAX_LEADERBOARD_ENTRIES = 100000;
+
+    TextureCache textures; // Owns every image texture, declared before the handles that point into it
+    TextureHandle fieldTexture;
+    TextureHandle snakeHeadUpTexture;
+    TextureHandle snakeHeadDownTexture;
+    TextureHandle snakeHeadLeftTexture;
+    TextureHandle snakeHeadRightTexture;
+    TextureHandle snakeBodyTexture;
+    TextureHandle snakeTailTexture;
+    TextureHandle foodTexture;
+    TextureHandle pooTexture;
+    TextureHandle startScreenTexture;
+    TextureHandle endScreenTexture;
+    unsigned long seenEvictions = 0; // An eviction may hand out a recycled pointer, the board layer is redrawn then
+
+    // Retained board layer, only the cells that changed since the last frame are redrawn into it
+    SDL_Texture* boardLayer = nullptr;
+    bool boardLayerValid = false; // False forces a full redraw of the layer (new game, resize, lost targets)
+    int fieldTextureWidth = 0;
+    int fieldTextureHeight = 0;
+    std::vector<SDL_Texture*> drawnCells; // Sprite currently on the layer for every cell
+    std::vector<SDL_Texture*> frameCells; // Sprite wanted for every cell this frame
 
-    SDL_Texture* fieldTexture = nullptr;
-    SDL_Texture* snakeHeadUpTexture = nullptr;
-    SDL_Texture* snakeHeadDownTexture = nullptr;
-    SDL_Texture* snakeHeadLeftTexture = nullptr;
-    SDL_Texture* snakeHeadRightTexture = nullptr;
-    SDL_Texture* snakeBodyTexture = nullptr;
-    SDL_Texture* snakeTailTexture = nullptr;
-    SDL_Texture* foodTexture = nullptr;
-    SDL_Texture* pooTexture = nullptr;
-    SDL_Texture* startScreenTexture = nullptr;
-    SDL_Texture* endScreenTexture = nullptr;
+    // The score is only rasterized again when it changes
+    SDL_Texture* scoreTexture = nullptr;
+    int scoreTextureValue = -1;
+    int scoreTextureWidth = 0;
+    int scoreTextureHeight = 0;
+    char textBuffer[128]; // Reused for formatting on-screen text
 
     Mix_Music* startScreenMusic = nullptr;
     Mix_Music* inGameMusic = nullptr;
@@ -72,11 +131,39 @@ private:
     void showLeaderboard();
     void resetGame();
     void mainLoop();
+    void threadedLoop();
+    void applySimFrame();
+    bool stopSimulation(); // Applies the last tick, true when that tick ended the game
+    void endGame();
+    void steer(int dir);
+    void autopilot();
+    void spectatorLoop();
+    bool loadWorld();
+    void resetWorld();
+    void worldLoop();
+    void handleWorldEvent(SDL_Event& e);
+    void updateWorld();
+    void renderWorld();
+    bool spawnWorldItem(uint8_t item, int& x, int& y);
+    void startGame();
+    bool buildSpectatorAtlas();
     void render();
+    bool createBoardLayer();
+    void destroyBoardLayer();
+    bool renderBoardLayer();
+    void renderFullBoard();
+    void collectBoardCells();
+    void drawBoardCell(int cell, SDL_Texture* sprite);
+    SDL_Texture* headTexture(Snake::Direction direction);
+    void renderScore();
+    void destroyScoreTexture();
     void update();
     void handleEvents(SDL_Event& e);
+    bool trackWindowEvent(const SDL_Event& e);
     void loadLeaderboard();
     void saveLeaderboard();
     void getPlayerName();
     void addScoreToLeaderboard(int score, const std::string& name);
+    void saveGame();
+    bool loadGame();
 };
@@ -1,12 +1,53 @@
 #include "GameBoard.h"
+#include "Zobrist.h"
+#include <cassert>
 #include <cstdlib>
 #include <ctime>
 
+static_assert(BoardSnapshot::COLUMNS == GameBoard::BOARD_WIDTH / GameBoard::FOOD_SEGMENT_SIZE &&
+              BoardSnapshot::ROWS == GameBoard::BOARD_HEIGHT / GameBoard::FOOD_SEGMENT_SIZE,
+              "BoardSnapshot grid doesn't match the board");
+
+// Pixel position <-> cell index as stored in snapshots, -1 is off the board
+static int16_t toCell(int x, int y) {
+    if (x < 0 || y < 0) {
+        return -1;
+    }
+    return static_cast<int16_t>((y / GameBoard::FOOD_SEGMENT_SIZE) * BoardSnapshot::COLUMNS + x / GameBoard::FOOD_SEGMENT_SIZE);
+}
+
+static int cellX(int cell) {
+    return cell < 0 ? -1 : (cell % BoardSnapshot::COLUMNS) * GameBoard::FOOD_SEGMENT_SIZE;
+}
+
+static int cellY(int cell) {
+    return cell < 0 ? -1 : (cell / BoardSnapshot::COLUMNS) * GameBoard::FOOD_SEGMENT_SIZE;
+}
+
+// Food and poo only count while they are on the board
+static uint64_t itemKey(ZobristFeature feature, const GameBoard::FoodSegment& item) {
+    return item.x < 0 ? 0 : zobristKey(feature, item.x, item.y);
+}
+
 GameBoard::GameBoard() {
-    generateFood();
     poo.x = -1;
 	poo.y = -1;
     snake = std::make_unique<Snake>(BOARD_WIDTH / 2 - Snake::BODY_SEGMENT_SIZE, BOARD_HEIGHT / 2); // Directly initialize here
+    // Food only spawns on free cells, so the snake can't get longer than the board has cells (+1 for the segment
+    // added when eating) and growing never reallocates
+    snake->body.reserve(BoardSnapshot::MAX_SEGMENTS);
+    generateFood(); // Needs the snake to find a free cell
+    itemsHash = computeItemsHash();
+}
+
+void GameBoard::reset() {
+    // Reuse the board and the snake storage instead of allocating new ones
+    generateFood();
+    poo.x = -1;
+    poo.y = -1;
+    score = 0;
+    snake->reset(BOARD_WIDTH / 2 - Snake::BODY_SEGMENT_SIZE, BOARD_HEIGHT / 2);
+    itemsHash = computeItemsHash();
 }
 
 GameBoard::~GameBoard() {}
@@ -15,17 +56,97 @@ void GameBoard::setSnake(Snake* newSnake) {
     snake.reset(newSnake); // Reset to the new snake
 }
 
+GameBoard::FoodSegment GameBoard::randomFreeCell(const FoodSegment& other) const {
+    // Mark the snake and the other item, then take the first free cell from a random start
+    bool taken[BoardSnapshot::BOARD_CELLS] = {};
+    for (const Snake::BodySegment& segment : snake->body) {
+        taken[toCell(segment.x, segment.y)] = true;
+    }
+    if (other.x >= 0) {
+        taken[toCell(other.x, other.y)] = true;
+    }
+    int start = std::rand() % BoardSnapshot::BOARD_CELLS;
+    for (int i = 0; i < BoardSnapshot::BOARD_CELLS; ++i) {
+        int cell = (start + i) % BoardSnapshot::BOARD_CELLS;
+        if (!taken[cell]) {
+            return { cellX(cell), cellY(cell) };
+        }
+    }
+    return { -1, -1 }; // The board is full
+}
+
 void GameBoard::generateFood() {
     std::srand(std::time(nullptr)); // This should ideally be called only once
-    food.x = std::rand() % (BOARD_WIDTH / FOOD_SEGMENT_SIZE) * FOOD_SEGMENT_SIZE;
-    food.y = std::rand() % (BOARD_HEIGHT / FOOD_SEGMENT_SIZE) * FOOD_SEGMENT_SIZE;
+    itemsHash ^= itemKey(ZobristFeature::FOOD, food);
+    food = randomFreeCell(poo); // Never on the snake, so eating can't grow it past the board
+    itemsHash ^= itemKey(ZobristFeature::FOOD, food);
 }
 
 void GameBoard::generatePoo() {
     std::srand(std::time(nullptr));  // This should ideally be called only once
-    do {
-        poo.x = std::rand() % (BOARD_WIDTH / FOOD_SEGMENT_SIZE) * FOOD_SEGMENT_SIZE;
-        poo.y = std::rand() % (BOARD_HEIGHT / FOOD_SEGMENT_SIZE) * FOOD_SEGMENT_SIZE;
-    } while (food.x == poo.x && food.y == poo.y || poo.x == snake->body[0].x && poo.y == snake->body[0].y); // Make sure the poo is not on the food nor snake
-    
+    itemsHash ^= itemKey(ZobristFeature::POO, poo);
+    poo = randomFreeCell(food); // Make sure the poo is not on the food nor snake
+    itemsHash ^= itemKey(ZobristFeature::POO, poo);
+}
+
+GameBoard::StepResult GameBoard::step() {
+    snake->moveSnake(BOARD_WIDTH, BOARD_HEIGHT);
+    const Snake::BodySegment& head = snake->body[0];
+    if (head.x == food.x && head.y == food.y) {
+        snake->growSnake(snake->body.back().x, snake->body.back().y);
+        generateFood();
+        setScore(score + 10); // Increase score when food is eaten
+        if (score >= 100) {
+            generatePoo();
+        }
+        return StepResult::ATE_FOOD;
+    }
+    if (snake->checkCollision() || (head.x == poo.x && head.y == poo.y)) {
+        return StepResult::DIED;
+    }
+    return StepResult::MOVED;
+}
+
+void GameBoard::setScore(int newScore) {
+    itemsHash ^= zobristKey(ZobristFeature::SCORE, score) ^ zobristKey(ZobristFeature::SCORE, newScore);
+    score = newScore;
+}
+
+uint64_t GameBoard::computeItemsHash() const {
+    return itemKey(ZobristFeature::FOOD, food) ^ itemKey(ZobristFeature::POO, poo) ^ zobristKey(ZobristFeature::SCORE, score);
+}
+
+uint64_t GameBoard::computeHash() const {
+    return computeItemsHash() ^ snake->computeHash();
+}
+
+
+void GameBoard::saveSnapshot(BoardSnapshot& snapshot) const {
+    const std::vector<Snake::BodySegment>& body = snake->body;
+    assert(body.size() <= BoardSnapshot::MAX_SEGMENTS);
+    snapshot.length = static_cast<uint16_t>(body.size());
+    snapshot.direction = static_cast<uint8_t>(snake->direction);
+    snapshot.foodCell = toCell(food.x, food.y);
+    snapshot.pooCell = toCell(poo.x, poo.y);
+    for (size_t i = 0; i < body.size(); ++i) {
+        snapshot.segments[i] = static_cast<uint16_t>(toCell(body[i].x, body[i].y));
+    }
+}
+
+void GameBoard::restoreSnapshot(const BoardSnapshot& snapshot) {
+    // resize stays within the capacity reserved in the constructor
+    snake->body.resize(snapshot.length);
+    for (size_t i = 0; i < snapshot.length; ++i) {
+        snake->body[i].x = cellX(snapshot.segments[i]);
+        snake->body[i].y = cellY(snapshot.segments[i]);
+    }
+    snake->direction = static_cast<Snake::Direction>(snapshot.direction);
+    food.x = cellX(snapshot.foodCell);
+    food.y = cellY(snapshot.foodCell);
+    poo.x = cellX(snapshot.pooCell);
+    poo.y = cellY(snapshot.pooCell);
+
+    // The whole state was replaced, hash it from scratch. The score follows through setScore
+    snake->rehash();
+    itemsHash = computeItemsHash();
 }
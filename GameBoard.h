@@ -2,6 +2,7 @@
 #include <iostream>
 #include <memory>
 #include "Snake.h"
+#include "BoardSnapshot.h"
 
 class GameBoard
 {
@@ -9,20 +10,41 @@ public:
     GameBoard();
     ~GameBoard();
     std::unique_ptr<Snake> snake; // Use smart pointer here
-    const int BOARD_WIDTH = 600;
-    const int BOARD_HEIGHT = 600;
-    const int FOOD_SEGMENT_SIZE = 20;
+    static const int BOARD_WIDTH = 600;
+    static const int BOARD_HEIGHT = 600;
+    static const int FOOD_SEGMENT_SIZE = 20;
 
     struct FoodSegment {
         int x;
         int y;
     };
 
-    FoodSegment food;
-    FoodSegment poo;
+    FoodSegment food = { -1, -1 };
+    FoodSegment poo = { -1, -1 };
 
+    enum class StepResult { MOVED, ATE_FOOD, DIED };
+
+    void reset();
+    // One tick of the rules: move, eat and grow, score, poo from 100 points on and collisions
+    StepResult step();
     void generateFood();
     void generatePoo();
+    void saveSnapshot(BoardSnapshot& snapshot) const;
+    void restoreSnapshot(const BoardSnapshot& snapshot);
+
+    // The score is kept by Game, the board only needs it for the hash
+    void setScore(int newScore);
+    int getScore() const { return score; }
+
+    // 64-bit hash of snake, direction, food, poo and score, updated on every change.
+    // Equal states give equal hashes, so replays and lockstep games can compare it tick by tick
+    uint64_t hash() const { return itemsHash ^ snake->hash(); }
+    uint64_t computeHash() const; // From scratch, to cross-check hash()
 private:
+    int score = 0;
+    uint64_t itemsHash = 0; // Food, poo and score, the snake hashes itself
+
+    uint64_t computeItemsHash() const;
+    FoodSegment randomFreeCell(const FoodSegment& other) const; // {-1, -1} when every cell is taken
     void setSnake(Snake* newSnake); // Clearer parameter naming
 };
@@ -0,0 +1,132 @@
+#include "LeaderboardView.h"
+#include <cstdio>
+
+static const size_t NO_ROW = static_cast<size_t>(-1);
+
+LeaderboardView::LeaderboardView(SDL_Renderer* renderer, TTF_Font* font, const std::vector<std::pair<int, std::string>>& entries, SDL_Rect area)
+    : renderer(renderer), font(font), entries(entries), area(area), highlighted(NO_ROW) {
+    rowsOnScreen = area.h / ROW_HEIGHT;
+    if (rowsOnScreen == 0) {
+        rowsOnScreen = 1;
+    }
+
+    // Any window of rowsOnScreen + 2 * CACHE_MARGIN consecutive rows maps to distinct slots
+    CachedRow empty = { NO_ROW, nullptr, 0, 0 };
+    cache.assign(rowsOnScreen + 2 * CACHE_MARGIN, empty);
+}
+
+LeaderboardView::~LeaderboardView() {
+    invalidate();
+}
+
+void LeaderboardView::invalidate() {
+    for (CachedRow& cached : cache) {
+        if (cached.texture != nullptr) {
+            SDL_DestroyTexture(cached.texture);
+            cached.texture = nullptr;
+        }
+        cached.index = NO_ROW;
+    }
+}
+
+size_t LeaderboardView::lastFirstRow() const {
+    return entries.size() > rowsOnScreen ? entries.size() - rowsOnScreen : 0;
+}
+
+void LeaderboardView::scrollBy(long rows) {
+    if (rows < 0 && static_cast<size_t>(-rows) > first) {
+        first = 0;
+    }
+    else {
+        first += rows;
+    }
+    if (first > lastFirstRow()) {
+        first = lastFirstRow();
+    }
+}
+
+void LeaderboardView::scrollToTop() {
+    first = 0;
+}
+
+void LeaderboardView::scrollToBottom() {
+    first = lastFirstRow();
+}
+
+void LeaderboardView::centerOn(size_t index) {
+    highlighted = index;
+    first = index > rowsOnScreen / 2 ? index - rowsOnScreen / 2 : 0;
+    if (first > lastFirstRow()) {
+        first = lastFirstRow();
+    }
+}
+
+bool LeaderboardView::jumpToRank(size_t rank) {
+    if (rank == 0 || rank > entries.size()) {
+        return false;
+    }
+    centerOn(rank - 1);
+    return true;
+}
+
+bool LeaderboardView::jumpToPlayer(const std::string& name) {
+    // Entries are sorted best first, so the first match is the best one
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].second == name) {
+            centerOn(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+LeaderboardView::CachedRow& LeaderboardView::row(size_t index) {
+    CachedRow& cached = cache[index % cache.size()];
+    if (cached.index == index) {
+        return cached;
+    }
+
+    // Slot belongs to a row that scrolled far enough away, rasterize the new one in its place
+    if (cached.texture != nullptr) {
+        SDL_DestroyTexture(cached.texture);
+        cached.texture = nullptr;
+    }
+    cached.index = index;
+    cached.width = 0;
+    cached.height = 0;
+
+    std::snprintf(rowText, sizeof(rowText), "%u. %s - %d", static_cast<unsigned>(index + 1), entries[index].second.c_str(), entries[index].first);
+    SDL_Color textColor = { 255, 255, 255, 255 }; // White color
+    SDL_Surface* surfaceRow = TTF_RenderText_Solid(font, rowText, textColor);
+    if (surfaceRow == nullptr) {
+        return cached;
+    }
+    cached.texture = SDL_CreateTextureFromSurface(renderer, surfaceRow);
+    cached.width = surfaceRow->w;
+    cached.height = surfaceRow->h;
+    SDL_FreeSurface(surfaceRow);
+    return cached;
+}
+
+void LeaderboardView::render() {
+    size_t last = first + rowsOnScreen;
+    if (last > entries.size()) {
+        last = entries.size();
+    }
+
+    int y = area.y;
+    for (size_t i = first; i < last; ++i) {
+        if (i == highlighted) {
+            SDL_Rect highlight = { area.x - 10, y - 2, area.w + 20, ROW_HEIGHT };
+            SDL_SetRenderDrawColor(renderer, 60, 90, 60, 255);
+            SDL_RenderFillRect(renderer, &highlight);
+        }
+
+        CachedRow& cached = row(i);
+        if (cached.texture != nullptr) {
+            SDL_Rect entryRect = { area.x, y, cached.width, cached.height };
+            SDL_RenderCopy(renderer, cached.texture, NULL, &entryRect);
+        }
+        y += ROW_HEIGHT;
+    }
+}
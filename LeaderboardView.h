@@ -0,0 +1,52 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Scrollable view over the leaderboard.
+Only the rows on screen are rasterized. Their textures sit in a small cache that also holds a
+few rows above and below the viewport, so the cost of a frame doesn't depend on the table size. */
+class LeaderboardView
+{
+public:
+    LeaderboardView(SDL_Renderer* renderer, TTF_Font* font, const std::vector<std::pair<int, std::string>>& entries, SDL_Rect area);
+    ~LeaderboardView();
+
+    void scrollBy(long rows);
+    void scrollToTop();
+    void scrollToBottom();
+    bool jumpToRank(size_t rank);                // rank starts at 1
+    bool jumpToPlayer(const std::string& name);  // Best entry of that player
+    void invalidate();                           // Drop all cached rows, e.g. after a device reset
+    void render();
+
+    size_t firstRow() const { return first; }
+    size_t visibleRows() const { return rowsOnScreen; }
+
+private:
+    static const int ROW_HEIGHT = 30;
+    static const int CACHE_MARGIN = 8; // Rows kept around the viewport in each direction
+
+    struct CachedRow {
+        size_t index;
+        SDL_Texture* texture;
+        int width;
+        int height;
+    };
+
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    const std::vector<std::pair<int, std::string>>& entries;
+    SDL_Rect area;
+    size_t rowsOnScreen;
+    size_t first = 0;
+    size_t highlighted;
+    std::vector<CachedRow> cache; // Direct mapped by row index
+    char rowText[128];
+
+    size_t lastFirstRow() const;
+    void centerOn(size_t index);
+    CachedRow& row(size_t index);
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* Read-only memory mapping of a whole file. Pages are only read from disk when touched. */
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* data() const { return view; }
+    size_t size() const { return length; }
+    bool isOpen() const { return view != nullptr; }
+
+private:
+#ifdef _WIN32
+    void* file = nullptr;    // HANDLE
+    void* mapping = nullptr; // HANDLE
+#else
+    int descriptor = -1;
+#endif
+    const uint8_t* view = nullptr;
+    size_t length = 0;
+};
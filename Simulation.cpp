@@ -0,0 +1,85 @@
+#include "Simulation.h"
+#include <chrono>
+
+Simulation::Simulation(const GameBoard& start, int score, bool pooSpawned)
+    : pooSpawned(pooSpawned) {
+    BoardSnapshot snapshot;
+    start.saveSnapshot(snapshot);
+    board.restoreSnapshot(snapshot);
+    board.setScore(score);
+
+    // The reader has a frame to draw before the first tick
+    publish(0);
+    thread = std::thread(&Simulation::run, this);
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::stop() {
+    stopping.store(true, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void Simulation::run() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration tickLength = std::chrono::milliseconds(TICK_MS);
+
+    Clock::time_point next = Clock::now();
+    while (!stopping.load(std::memory_order_acquire) && !gameOver) {
+        // Sleep to an absolute time so late ticks don't push back the ones after them
+        next += tickLength;
+        std::this_thread::sleep_until(next);
+        Clock::time_point now = Clock::now();
+
+        double lateMs = std::chrono::duration<double, std::milli>(now - next).count();
+        jitterSumMs += lateMs;
+        if (lateMs > jitterMaxMs) {
+            jitterMaxMs = lateMs;
+        }
+        if (now - next > tickLength) {
+            next = now; // Stalled for more than a tick (debugger, suspend), don't race to catch up
+        }
+        if (stopping.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        // Apply the key presses in the order they were made, like the polled events before Game::update
+        int8_t dir;
+        while (input.pop(dir)) {
+            board.snake->setDirection(dir);
+        }
+
+        tick();
+        publish(++tickCount);
+    }
+}
+
+void Simulation::tick() {
+    // Same GameBoard::step as Game::update, the sounds are played by the reader
+    GameBoard::StepResult result = board.step();
+    if (result == GameBoard::StepResult::ATE_FOOD) {
+        ++foodEaten;
+        if (board.getScore() >= 100) {
+            pooSpawned = true;
+        }
+    }
+    else if (result == GameBoard::StepResult::DIED) {
+        gameOver = true;
+    }
+}
+
+void Simulation::publish(uint32_t tick) {
+    SimFrame& frame = frames.back();
+    board.saveSnapshot(frame.board);
+    frame.hash = board.hash();
+    frame.tick = tick;
+    frame.score = board.getScore();
+    frame.foodEaten = foodEaten;
+    frame.pooSpawned = pooSpawned;
+    frame.gameOver = gameOver;
+    frames.publish();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "GameBoard.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+// Complete state after one tick, what the render thread draws
+struct SimFrame {
+    BoardSnapshot board;
+    uint64_t hash = 0;        // GameBoard::hash of this state
+    uint32_t tick = 0;
+    int32_t score = 0;
+    uint32_t foodEaten = 0;   // Counts up, the reader plays a sound for every food it hasn't seen
+    bool pooSpawned = false;
+    bool gameOver = false;
+};
+
+/* Runs the game rules on their own thread with a fixed tick.
+The simulation owns a private copy of the board. After every tick it publishes a SimFrame through
+a triple buffer, so drawing or a slow present never delays the next tick. Steering goes the other
+way through a lock-free queue. Nothing here touches SDL. */
+class Simulation
+{
+public:
+    static const int TICK_MS = 100; // Same speed as the single threaded loop
+
+    // Starts ticking right away from the given state
+    Simulation(const GameBoard& start, int score, bool pooSpawned);
+    ~Simulation();
+
+    void steer(int dir) { input.push(static_cast<int8_t>(dir)); } // Same encoding as Snake::setDirection
+    void stop();
+
+    // Render thread: true when a newer frame than the last one returned is available
+    bool pollFrame() { return frames.update(); }
+    const SimFrame& frame() const { return frames.front(); }
+
+    // Lateness of the ticks against their schedule, only valid after stop
+    uint32_t ticks() const { return tickCount; }
+    double meanJitterMs() const { return tickCount == 0 ? 0.0 : jitterSumMs / tickCount; }
+    double maxJitterMs() const { return jitterMaxMs; }
+
+private:
+    GameBoard board; // Keeps the score too
+    bool pooSpawned;
+    uint32_t foodEaten = 0;
+    bool gameOver = false;
+
+    TripleBuffer<SimFrame> frames;
+    SpscQueue<int8_t, 64> input;
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+
+    uint32_t tickCount = 0;
+    double jitterSumMs = 0.0;
+    double jitterMaxMs = 0.0;
+
+    void run();
+    void tick();
+    void publish(uint32_t tick);
+};
@@ -1,8 +1,11 @@
 #include "Snake.h"
+#include "Zobrist.h"
 
 
 Snake::Snake(int startX, int startY) {
 	direction = Direction::RIGHT; // Default direction
+	snakeHash = zobristKey(ZobristFeature::DIRECTION, static_cast<int>(direction));
+	segmentSum = 0;
 	growSnake(startX, startY); // Start position for snake
 }
 
@@ -12,11 +15,25 @@ Snake::~Snake() {
 }
 
 
+void Snake::reset(int startX, int startY) {
+	body.clear(); // Keeps the capacity, a new game doesn't allocate
+	direction = Direction::RIGHT;
+	snakeHash = zobristKey(ZobristFeature::DIRECTION, static_cast<int>(direction));
+	segmentSum = 0;
+	growSnake(startX, startY);
+}
+
+
 void Snake::growSnake(int xpos, int ypos) {
 	body.push_back({xpos, ypos});// 
+	segmentSum += zobristKey(ZobristFeature::SNAKE, xpos, ypos);
+	if (body.size() == 1) {
+		snakeHash ^= zobristKey(ZobristFeature::HEAD, xpos, ypos);
+	}
 }
 
 void Snake::setDirection(int dir) {
+	Direction previous = direction;
 	if (dir == 0 && direction != Direction::DOWN) {
 		direction = Direction::UP;
 	}
@@ -29,11 +46,18 @@ void Snake::setDirection(int dir) {
 	else if (dir == 3 && direction != Direction::LEFT) {
 		direction = Direction::RIGHT;
 	}
+	if (direction != previous) {
+		snakeHash ^= zobristKey(ZobristFeature::DIRECTION, static_cast<int>(previous)) ^ zobristKey(ZobristFeature::DIRECTION, static_cast<int>(direction));
+	}
 }
 
 
 
 void Snake::moveSnake(int BOARD_WIDTH, int BOARD_HEIGHT) {
+    // Only the tail leaves and the head moves, the segments in between keep their cells
+    segmentSum -= zobristKey(ZobristFeature::SNAKE, body.back().x, body.back().y);
+    snakeHash ^= zobristKey(ZobristFeature::HEAD, body[0].x, body[0].y);
+
     // Move the rest of the body
     for (size_t i = body.size() - 1; i > 0; --i) {
         body[i] = body[i - 1];
@@ -52,6 +76,9 @@ void Snake::moveSnake(int BOARD_WIDTH, int BOARD_HEIGHT) {
     else if (body[0].x >= BOARD_WIDTH) body[0].x = 0;
     if (body[0].y < 0) body[0].y = BOARD_HEIGHT - BODY_SEGMENT_SIZE;
     else if (body[0].y >= BOARD_HEIGHT) body[0].y = 0;
+
+    segmentSum += zobristKey(ZobristFeature::SNAKE, body[0].x, body[0].y);
+    snakeHash ^= zobristKey(ZobristFeature::HEAD, body[0].x, body[0].y);
 }
 
 
@@ -63,4 +90,29 @@ bool Snake::checkCollision() {
         }
     }
     return false;
+}
+
+uint64_t Snake::headKeys() const {
+    uint64_t h = zobristKey(ZobristFeature::DIRECTION, static_cast<int>(direction));
+    if (!body.empty()) {
+        h ^= zobristKey(ZobristFeature::HEAD, body[0].x, body[0].y);
+    }
+    return h;
+}
+
+uint64_t Snake::sumSegmentKeys() const {
+    uint64_t sum = 0;
+    for (const BodySegment& segment : body) {
+        sum += zobristKey(ZobristFeature::SNAKE, segment.x, segment.y);
+    }
+    return sum;
+}
+
+uint64_t Snake::computeHash() const {
+    return headKeys() ^ sumSegmentKeys();
+}
+
+void Snake::rehash() {
+    snakeHash = headKeys();
+    segmentSum = sumSegmentKeys();
 }
\ No newline at end of file
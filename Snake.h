@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <cstdint>
 
 class Snake
 {
@@ -9,10 +10,17 @@ public:
 	~Snake();
 	static const int BODY_SEGMENT_SIZE = 20;
 	enum class Direction { UP, DOWN, LEFT, RIGHT } direction;
+	void reset(int startX, int startY);
 	void setDirection(int dir);
 	void moveSnake(int BOARD_WIDTH, int BOARD_HEIGHT);
 	void growSnake(int xpos, int ypos);
 	bool checkCollision();
+
+	// Hash of the body, the head and the direction, kept up to date by the methods above.
+	// Code that writes to body directly has to call rehash afterwards
+	uint64_t hash() const { return snakeHash ^ segmentSum; }
+	uint64_t computeHash() const;
+	void rehash();
 	struct BodySegment {
 		int x;
 		int y;
@@ -22,6 +30,10 @@ public:
 
 
 private:
+	uint64_t snakeHash = 0;  // Head and direction keys, XORed
+	uint64_t segmentSum = 0; // Segment keys, added up: the tail is doubled after eating and XOR would cancel it
+	uint64_t headKeys() const;
+	uint64_t sumSegmentKeys() const;
 	
 	
 
@@ -0,0 +1,217 @@
+#include "SnakeEnv.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+SnakeVectorEnv::SnakeVectorEnv(int numEnvs, int width, int height, uint64_t seed, int numThreads) {
+    if (numEnvs < 1) {
+        numEnvs = 1;
+    }
+    if (numThreads < 1) {
+        numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (numThreads > numEnvs) {
+        numThreads = numEnvs;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    // Every board gets its own seed so the episodes differ
+    boards.reserve(numEnvs);
+    seeds.reserve(numEnvs);
+    nextSeed = seed;
+    for (int i = 0; i < numEnvs; ++i) {
+        boards.push_back(createBoardEngine(width, height));
+        if (!boards.back()) {
+            throw std::invalid_argument("Unsupported board size");
+        }
+        seeds.push_back(++nextSeed);
+    }
+    observationBytes = static_cast<size_t>(boards[0]->width()) * boards[0]->height() * 4;
+
+    // The calling thread works on slice 0, the workers on the rest
+    try {
+        for (int slice = 1; slice < numThreads; ++slice) {
+            workers.push_back(std::thread(&SnakeVectorEnv::workerLoop, this, slice));
+        }
+    }
+    catch (...) {
+        // The destructor doesn't run for a half built object, the started workers have to be joined here
+        stopWorkers();
+        throw;
+    }
+}
+
+SnakeVectorEnv::~SnakeVectorEnv() {
+    stopWorkers();
+}
+
+void SnakeVectorEnv::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void SnakeVectorEnv::reset(uint8_t* observations) {
+    this->observations = observations;
+    resetting = true;
+    runAll();
+}
+
+void SnakeVectorEnv::step(const int32_t* actions, float* rewards, uint8_t* dones, uint8_t* observations) {
+    this->actions = actions;
+    this->rewards = rewards;
+    this->dones = dones;
+    this->observations = observations;
+    resetting = false;
+    runAll();
+}
+
+void SnakeVectorEnv::runAll() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = static_cast<int>(workers.size());
+        ++generation;
+    }
+    workReady.notify_all();
+
+    runSlice(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pending == 0; });
+}
+
+void SnakeVectorEnv::runSlice(int slice) {
+    const size_t slices = workers.size() + 1;
+    const size_t begin = boards.size() * slice / slices;
+    const size_t end = boards.size() * (slice + 1) / slices;
+
+    for (size_t i = begin; i < end; ++i) {
+        BoardEngine& board = *boards[i];
+        if (resetting) {
+            board.reset(seeds[i]);
+        }
+        else {
+            board.setDirection(actions[i]);
+            BoardEngine::StepResult result = board.step();
+            rewards[i] = result == BoardEngine::StepResult::ATE_FOOD ? 1.0f : (result == BoardEngine::StepResult::DIED ? -1.0f : 0.0f);
+            dones[i] = result == BoardEngine::StepResult::DIED;
+            if (result == BoardEngine::StepResult::DIED) {
+                // Same storage, new episode. The seed only has to differ from the other boards
+                seeds[i] += boards.size();
+                board.reset(seeds[i]);
+            }
+        }
+        if (observations != nullptr) {
+            board.writeObservation(observations + i * observationBytes);
+        }
+    }
+}
+
+void SnakeVectorEnv::workerLoop(int slice) {
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runSlice(slice);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --pending == 0;
+        }
+        if (last) {
+            workDone.notify_one();
+        }
+    }
+}
+
+void benchmarkVectorEnv() {
+    const int numEnvs = 4096;
+    const int steps = 500;
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    std::vector<int32_t> actions(numEnvs);
+    std::vector<float> rewards(numEnvs);
+    std::vector<uint8_t> dones(numEnvs);
+
+    // Powers of two below the core count, then every core
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::cout << "threads  env-steps/s" << std::endl;
+
+    for (int threads : threadCounts) {
+        SnakeVectorEnv env(numEnvs, 30, 30, 1, threads);
+        std::vector<uint8_t> observations(env.observationSize() * numEnvs);
+        env.reset(observations.data());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; ++step) {
+            for (int i = 0; i < numEnvs; ++i) {
+                actions[i] = (i + step / 8) & 3;
+            }
+            env.step(actions.data(), rewards.data(), dones.data(), observations.data());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << threads << "  " << static_cast<long>(numEnvs * static_cast<double>(steps) / seconds) << std::endl;
+    }
+}
+
+extern "C" {
+
+SnakeVectorEnv* snake_env_create(int num_envs, int width, int height, uint64_t seed, int num_threads) {
+    if (num_envs < 1) {
+        return nullptr;
+    }
+    // No exception may cross into the C caller
+    try {
+        return new SnakeVectorEnv(num_envs, width, height, seed, num_threads);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to create the snake environment! " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void snake_env_destroy(SnakeVectorEnv* env) {
+    delete env;
+}
+
+size_t snake_env_observation_size(const SnakeVectorEnv* env) {
+    return env != nullptr ? env->observationSize() : 0;
+}
+
+void snake_env_reset(SnakeVectorEnv* env, uint8_t* observations) {
+    if (env != nullptr) {
+        env->reset(observations);
+    }
+}
+
+void snake_env_step(SnakeVectorEnv* env, const int32_t* actions, float* rewards, uint8_t* dones, uint8_t* observations) {
+    if (env != nullptr && actions != nullptr && rewards != nullptr && dones != nullptr) {
+        env->step(actions, rewards, dones, observations);
+    }
+}
+
+}
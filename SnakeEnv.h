@@ -0,0 +1,77 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/* Vectorized environment for training bots.
+One environment owns N boards and steps all of them at once. Observations are written straight
+into a caller provided buffer of N * observation size bytes: per board four width * height planes
+(snake, head, food, poo). Rewards are +1 for food, -1 for dying and 0 otherwise. A board that dies
+is reset in place right away and its observation shows the start of the next episode.
+Actions use the encoding of Snake::setDirection: 0 up, 1 down, 2 left, 3 right. */
+
+#ifdef __cplusplus
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BitBoardEngine.h"
+
+class SnakeVectorEnv
+{
+public:
+    SnakeVectorEnv(int numEnvs, int width, int height, uint64_t seed, int numThreads);
+    ~SnakeVectorEnv();
+
+    int size() const { return static_cast<int>(boards.size()); }
+    size_t observationSize() const { return observationBytes; }
+    void reset(uint8_t* observations);
+    void step(const int32_t* actions, float* rewards, uint8_t* dones, uint8_t* observations);
+
+private:
+    std::vector<std::unique_ptr<BoardEngine>> boards;
+    std::vector<uint64_t> seeds;
+    uint64_t nextSeed;
+    size_t observationBytes;
+
+    // Arguments of the call in progress, read by the workers
+    const int32_t* actions = nullptr;
+    float* rewards = nullptr;
+    uint8_t* dones = nullptr;
+    uint8_t* observations = nullptr;
+    bool resetting = false;
+
+    // Workers sleep until the generation changes, then each one takes its own slice of boards
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    unsigned long generation = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    void runAll();
+    void runSlice(int slice);
+    void workerLoop(int slice);
+    void stopWorkers();
+};
+
+// Prints env-steps per second for a few thread counts
+void benchmarkVectorEnv();
+
+extern "C" {
+#endif
+
+typedef struct SnakeVectorEnv SnakeVectorEnv;
+
+// NULL when the arguments are invalid (no boards, unsupported size) or memory runs out
+SnakeVectorEnv* snake_env_create(int num_envs, int width, int height, uint64_t seed, int num_threads);
+void snake_env_destroy(SnakeVectorEnv* env);
+size_t snake_env_observation_size(const SnakeVectorEnv* env);
+void snake_env_reset(SnakeVectorEnv* env, uint8_t* observations);
+void snake_env_step(SnakeVectorEnv* env, const int32_t* actions, float* rewards, uint8_t* dones, uint8_t* observations);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,14 +3,58 @@
 #include <SDL_main.h>
 #include <iostream>
 #include <vector>
+#include <string>
 #include <cstdlib>
 #include <ctime>
 #include "Game.h"
+#include "SnakeEnv.h"
 
 
 int main(int argc, char* argv[]){
+    GameOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--capture" && i + 1 < argc) {
+            options.captureDirectory = argv[++i];
+        }
+        else if (arg == "--capture-png") {
+            options.capturePng = true;
+        }
+        else if (arg == "--headless") {
+            options.headless = true;
+        }
+        else if (arg == "--track-allocations") {
+            options.trackAllocations = true;
+        }
+        else if (arg == "--texture-budget" && i + 1 < argc) {
+            options.textureBudgetMB = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--spectate" && i + 1 < argc) {
+            options.spectateBoards = std::atoi(argv[++i]);
+        }
+        else if (arg == "--world" && i + 1 < argc) {
+            options.worldPath = argv[++i];
+        }
+        else if (arg == "--world-size" && i + 1 < argc) {
+            options.worldSize = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threaded-sim") {
+            options.threadedSim = true;
+        }
+        else if (arg == "--bench-snapshots") {
+            benchmarkSnapshots();
+            return 0;
+        }
+        else if (arg == "--bench-env") {
+            benchmarkVectorEnv();
+            return 0;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+        }
+    }
 
-    Game game;
+    Game game(options);
     game.run();
     return 0;
 }
\ No newline at end of file
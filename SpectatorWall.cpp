@@ -0,0 +1,241 @@
+#include "SpectatorWall.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+SpectatorWall::SpectatorWall(SDL_Renderer* renderer, int boardCount, int viewWidth, int viewHeight)
+    : renderer(renderer), viewWidth(viewWidth), viewHeight(viewHeight) {
+    columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(boardCount))));
+    if (columns < 1) {
+        columns = 1;
+    }
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        spriteUV[i][0] = spriteUV[i][1] = SDL_FPoint{ 0.0f, 0.0f };
+    }
+
+    boards.reserve(boardCount);
+    for (int i = 0; i < boardCount; ++i) {
+        boards.push_back(createBoardEngine(GRID_SIZE, GRID_SIZE));
+        seeds.push_back(static_cast<uint64_t>(i) + 1);
+        boards.back()->reset(seeds.back());
+    }
+
+    // Room for background, food, poo and a short snake on every board, longer snakes grow it once
+    size_t quads = boards.size() * 8;
+    vertices.reserve(quads * 4);
+    indices.reserve(quads * 6);
+}
+
+SpectatorWall::~SpectatorWall() {
+    destroyAtlas();
+}
+
+bool SpectatorWall::buildAtlas(SDL_Texture* const sprites[WHITE]) {
+    destroyAtlas();
+    if (!SDL_RenderTargetSupported(renderer)) {
+        return false;
+    }
+
+    const int stride = ATLAS_SLOT + 2 * ATLAS_PADDING;
+    atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, stride * SPRITE_COUNT, stride);
+    if (atlas == nullptr) {
+        std::cerr << "Failed to create sprite atlas! SDL Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    atlasWidth = static_cast<float>(stride * SPRITE_COUNT);
+    atlasHeight = static_cast<float>(stride);
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, atlas);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        // Stretch each sprite over its slot including the padding, so filtering at the edges samples the sprite itself
+        SDL_Rect padded = { i * stride, 0, stride, stride };
+        if (i == WHITE) {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_RenderFillRect(renderer, &padded);
+        }
+        else if (sprites[i] != nullptr) {
+            SDL_RenderCopy(renderer, sprites[i], NULL, &padded);
+        }
+
+        // Half a texel inside the slot
+        spriteUV[i][0].x = (i * stride + ATLAS_PADDING + 0.5f) / atlasWidth;
+        spriteUV[i][0].y = (ATLAS_PADDING + 0.5f) / atlasHeight;
+        spriteUV[i][1].x = (i * stride + ATLAS_PADDING + ATLAS_SLOT - 0.5f) / atlasWidth;
+        spriteUV[i][1].y = (ATLAS_PADDING + ATLAS_SLOT - 0.5f) / atlasHeight;
+    }
+    SDL_SetRenderTarget(renderer, previousTarget);
+    return true;
+}
+
+void SpectatorWall::destroyAtlas() {
+    if (atlas != nullptr) {
+        SDL_DestroyTexture(atlas);
+        atlas = nullptr;
+    }
+}
+
+void SpectatorWall::update(Uint32 now) {
+    if (now - lastTick < TICK_MS) {
+        return;
+    }
+    lastTick = now;
+
+    for (size_t i = 0; i < boards.size(); ++i) {
+        BoardEngine& board = *boards[i];
+        board.setDirection(chooseDirection(board));
+        if (board.step() == BoardEngine::StepResult::DIED) {
+            // Start the next game right away on the same storage
+            seeds[i] += boards.size();
+            board.reset(seeds[i]);
+        }
+    }
+}
+
+int SpectatorWall::chooseDirection(const BoardEngine& board) {
+    // Greedy bot: the safe direction that gets closest to the food, wrapping around the edges
+    const int w = board.width();
+    const int h = board.height();
+    int head = board.segment(0);
+    int tail = board.segment(board.length() - 1);
+    int food = board.foodCell();
+    int headX = head % w;
+    int headY = head / w;
+    const int reverse[] = { 1, 0, 3, 2 };
+
+    int best = board.direction();
+    int bestDistance = -1;
+    for (int dir = 0; dir < 4; ++dir) {
+        if (dir == reverse[board.direction()]) {
+            continue;
+        }
+        int x = headX + (dir == 3) - (dir == 2);
+        int y = headY + (dir == 1) - (dir == 0);
+        x = (x + w) % w;
+        y = (y + h) % h;
+        int next = y * w + x;
+        if ((board.isOccupied(next) && next != tail) || next == board.pooCell()) {
+            continue;
+        }
+
+        int distance = 0;
+        if (food >= 0) {
+            int dx = std::abs(x - food % w);
+            int dy = std::abs(y - food / w);
+            distance = std::min(dx, w - dx) + std::min(dy, h - dy);
+        }
+        if (bestDistance < 0 || distance < bestDistance) {
+            bestDistance = distance;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+void SpectatorWall::handleKey(int key) {
+    const float pan = viewWidth * zoom / columns; // One tile
+    switch (key) {
+    case SDLK_UP:    offsetY += pan; break;
+    case SDLK_DOWN:  offsetY -= pan; break;
+    case SDLK_LEFT:  offsetX += pan; break;
+    case SDLK_RIGHT: offsetX -= pan; break;
+    case SDLK_HOME:  zoom = 1.0f; offsetX = 0.0f; offsetY = 0.0f; break;
+    }
+}
+
+void SpectatorWall::zoomBy(int steps) {
+    // Zoom around the centre of the window
+    float factor = std::pow(1.25f, static_cast<float>(steps));
+    float centerX = viewWidth / 2.0f;
+    float centerY = viewHeight / 2.0f;
+    offsetX = centerX - (centerX - offsetX) * factor;
+    offsetY = centerY - (centerY - offsetY) * factor;
+    zoom *= factor;
+    if (zoom < 1.0f) {
+        zoom = 1.0f;
+        offsetX = 0.0f;
+        offsetY = 0.0f;
+    }
+}
+
+void SpectatorWall::addQuad(float x, float y, float size, Sprite sprite, SDL_Color color) {
+    int first = static_cast<int>(vertices.size());
+    const SDL_FPoint& uv0 = spriteUV[sprite][0];
+    const SDL_FPoint& uv1 = spriteUV[sprite][1];
+    SDL_Vertex corners[4] = {
+        { { x, y }, color, { uv0.x, uv0.y } },
+        { { x + size, y }, color, { uv1.x, uv0.y } },
+        { { x + size, y + size }, color, { uv1.x, uv1.y } },
+        { { x, y + size }, color, { uv0.x, uv1.y } },
+    };
+    vertices.insert(vertices.end(), corners, corners + 4);
+    const int quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+    indices.insert(indices.end(), quad, quad + 6);
+}
+
+void SpectatorWall::addBoard(const BoardEngine& board, float x, float y, float tileSize) {
+    const float cell = tileSize / board.width();
+    const SDL_Color white = { 255, 255, 255, 255 };
+    const bool sprites = atlas != nullptr && cell >= MIN_SPRITE_CELL;
+    auto cellX = [&](int index) { return x + (index % board.width()) * cell; };
+    auto cellY = [&](int index) { return y + (index / board.width()) * cell; };
+
+    if (sprites) {
+        addQuad(x, y, tileSize, FIELD, white);
+        addQuad(cellX(board.foodCell()), cellY(board.foodCell()), cell, FOOD, white);
+        if (board.pooCell() >= 0) {
+            addQuad(cellX(board.pooCell()), cellY(board.pooCell()), cell, POO, white);
+        }
+        for (int i = board.length() - 1; i > 0; --i) {
+            int segment = board.segment(i);
+            addQuad(cellX(segment), cellY(segment), cell, BODY, white);
+        }
+        const Sprite heads[] = { HEAD_UP, HEAD_DOWN, HEAD_LEFT, HEAD_RIGHT };
+        addQuad(cellX(board.segment(0)), cellY(board.segment(0)), cell, heads[board.direction()], white);
+        return;
+    }
+
+    // Low detail: solid cells on a flat background
+    const SDL_Color field = { 40, 70, 40, 255 };
+    const SDL_Color food = { 220, 60, 40, 255 };
+    const SDL_Color poo = { 110, 70, 30, 255 };
+    const SDL_Color body = { 120, 200, 80, 255 };
+    const SDL_Color head = { 230, 240, 120, 255 };
+    addQuad(x, y, tileSize, WHITE, field);
+    addQuad(cellX(board.foodCell()), cellY(board.foodCell()), cell, WHITE, food);
+    if (board.pooCell() >= 0) {
+        addQuad(cellX(board.pooCell()), cellY(board.pooCell()), cell, WHITE, poo);
+    }
+    for (int i = board.length() - 1; i > 0; --i) {
+        int segment = board.segment(i);
+        addQuad(cellX(segment), cellY(segment), cell, WHITE, body);
+    }
+    addQuad(cellX(board.segment(0)), cellY(board.segment(0)), cell, WHITE, head);
+}
+
+void SpectatorWall::render() {
+    vertices.clear();
+    indices.clear();
+
+    const float gap = 2.0f;
+    const float pitch = viewWidth * zoom / columns;
+    const float tileSize = pitch - gap;
+    for (size_t i = 0; i < boards.size(); ++i) {
+        float x = offsetX + (i % columns) * pitch;
+        float y = offsetY + (i / columns) * pitch;
+
+        // Off-screen boards cost nothing
+        if (x + tileSize < 0 || y + tileSize < 0 || x >= viewWidth || y >= viewHeight) {
+            continue;
+        }
+        addBoard(*boards[i], x, y, tileSize);
+    }
+
+    if (!vertices.empty()) {
+        SDL_RenderGeometry(renderer, atlas, vertices.data(), static_cast<int>(vertices.size()), indices.data(), static_cast<int>(indices.size()));
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <SDL.h>
+#include <memory>
+#include <vector>
+#include "BitBoardEngine.h"
+
+/* Grid of bot-driven boards for monitoring many games at once.
+Everything on screen goes out in a single SDL_RenderGeometry call: sprites come from one atlas
+texture and solid quads use a white texel of the same atlas. Boards outside the window are
+skipped and boards too small for sprites are drawn as solid cells. */
+class SpectatorWall
+{
+public:
+    enum Sprite { HEAD_UP, HEAD_DOWN, HEAD_LEFT, HEAD_RIGHT, BODY, FOOD, POO, FIELD, WHITE, SPRITE_COUNT };
+
+    SpectatorWall(SDL_Renderer* renderer, int boardCount, int viewWidth, int viewHeight);
+    ~SpectatorWall();
+
+    bool buildAtlas(SDL_Texture* const sprites[WHITE]); // Sprites in the order of the Sprite enum
+    void destroyAtlas();
+    void update(Uint32 now);
+    void render();
+    void handleKey(int key);
+    void zoomBy(int steps);
+
+private:
+    static const int GRID_SIZE = 30;       // Cells per side, same as the 600px game board
+    static const int TICK_MS = 100;        // Same speed as Game::mainLoop
+    static const int ATLAS_SLOT = 32;      // Sprite size inside the atlas
+    static const int ATLAS_PADDING = 2;    // Keeps filtering from bleeding between slots
+    static const int MIN_SPRITE_CELL = 8;  // Smaller cells are drawn as solid quads
+
+    SDL_Renderer* renderer;
+    std::vector<std::unique_ptr<BoardEngine>> boards;
+    std::vector<uint64_t> seeds;
+    int viewWidth;
+    int viewHeight;
+    int columns;
+    float zoom = 1.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+    Uint32 lastTick = 0;
+
+    SDL_Texture* atlas = nullptr;
+    float atlasWidth = 1.0f;
+    float atlasHeight = 1.0f;
+    SDL_FPoint spriteUV[SPRITE_COUNT][2]; // Top left and bottom right in texture coordinates
+
+    // Reused every frame, they only grow until the busiest frame fits
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    void addQuad(float x, float y, float size, Sprite sprite, SDL_Color color);
+    void addBoard(const BoardEngine& board, float x, float y, float tileSize);
+    static int chooseDirection(const BoardEngine& board);
+};
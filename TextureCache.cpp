@@ -0,0 +1,211 @@
+#include "TextureCache.h"
+#include <SDL_image.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+TextureHandle::TextureHandle(const TextureHandle& other) : cache(other.cache), key(other.key) {
+    if (cache != nullptr) {
+        cache->retain(key);
+    }
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) : cache(other.cache), key(other.key) {
+    other.cache = nullptr;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle other) {
+    std::swap(cache, other.cache);
+    std::swap(key, other.key);
+    return *this;
+}
+
+TextureHandle::~TextureHandle() {
+    reset();
+}
+
+SDL_Texture* TextureHandle::get() const {
+    return cache != nullptr ? cache->use(key) : nullptr;
+}
+
+void TextureHandle::reset() {
+    if (cache != nullptr) {
+        cache->release(key);
+        cache = nullptr;
+    }
+}
+
+TextureCache::~TextureCache() {
+    clear();
+}
+
+void TextureCache::init(SDL_Renderer* renderer, size_t budgetBytes) {
+    this->renderer = renderer;
+    budget = budgetBytes;
+}
+
+TextureHandle TextureCache::load(const std::string& path) {
+    // A path seen before is still resolved to the same contents
+    auto known = pathKeys.find(path);
+    if (known != pathKeys.end() && entries.count(known->second) != 0) {
+        ++hitCount;
+        retain(known->second);
+        return TextureHandle(this, known->second);
+    }
+
+    std::string bytes;
+    if (!readFile(path, bytes)) {
+        return TextureHandle();
+    }
+    uint64_t key = hashContents(bytes);
+    pathKeys[path] = key;
+
+    // Same image under another name, share the texture
+    if (entries.count(key) != 0) {
+        ++hitCount;
+        retain(key);
+        return TextureHandle(this, key);
+    }
+
+    ++missCount;
+    Entry entry = { path, nullptr, 0, 0, recentlyUsed.end() };
+    if (!decode(entry, bytes)) {
+        return TextureHandle();
+    }
+    recentlyUsed.push_front(key);
+    entry.recent = recentlyUsed.begin();
+    entry.references = 1;
+    resident += entry.bytes;
+    entries.insert(std::make_pair(key, entry));
+
+    trim();
+    return TextureHandle(this, key);
+}
+
+void TextureCache::trim() {
+    // Oldest first, the texture used most recently is never evicted
+    while (resident > budget && recentlyUsed.size() > 1) {
+        evict(recentlyUsed.back());
+    }
+}
+
+void TextureCache::invalidate() {
+    for (auto item = entries.begin(); item != entries.end();) {
+        if (item->second.texture != nullptr) {
+            SDL_DestroyTexture(item->second.texture);
+            item->second.texture = nullptr;
+        }
+        item->second.recent = recentlyUsed.end();
+        item = item->second.references == 0 ? entries.erase(item) : std::next(item);
+    }
+    recentlyUsed.clear();
+    resident = 0;
+}
+
+void TextureCache::clear() {
+    invalidate();
+    entries.clear();
+    pathKeys.clear();
+}
+
+bool TextureCache::readFile(const std::string& path, std::string& bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << "!" << std::endl;
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+uint64_t TextureCache::hashContents(const std::string& bytes) {
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool TextureCache::decode(Entry& entry, const std::string& bytes) {
+    SDL_Surface* surface = IMG_Load_RW(SDL_RWFromConstMem(bytes.data(), static_cast<int>(bytes.size())), 1);
+    if (surface == nullptr) {
+        std::cerr << "Failed to decode " << entry.path << "! IMG Error: " << IMG_GetError() << std::endl;
+        return false;
+    }
+    entry.texture = SDL_CreateTextureFromSurface(renderer, surface);
+    entry.bytes = static_cast<size_t>(surface->w) * surface->h * 4; // Estimate, drivers keep 32-bit texels
+    SDL_FreeSurface(surface);
+    if (entry.texture == nullptr) {
+        std::cerr << "Failed to create texture for " << entry.path << "! SDL Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void TextureCache::retain(uint64_t key) {
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        ++found->second.references;
+    }
+}
+
+void TextureCache::release(uint64_t key) {
+    // Unused textures stay resident until the budget pushes them out
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        --found->second.references;
+        if (found->second.references == 0 && found->second.texture == nullptr) {
+            entries.erase(found);
+        }
+    }
+}
+
+SDL_Texture* TextureCache::use(uint64_t key) {
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    Entry& entry = found->second;
+
+    if (entry.texture == nullptr) {
+        // Evicted earlier, decode it again. Trimming waits for the end of the frame so pointers handed out stay valid
+        std::string bytes;
+        ++missCount;
+        if (!readFile(entry.path, bytes) || !decode(entry, bytes)) {
+            return nullptr;
+        }
+        resident += entry.bytes;
+        recentlyUsed.push_front(key);
+        entry.recent = recentlyUsed.begin();
+    }
+    else if (entry.recent != recentlyUsed.begin()) {
+        recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, entry.recent);
+    }
+    return entry.texture;
+}
+
+void TextureCache::evict(uint64_t key) {
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return;
+    }
+    Entry& entry = found->second;
+    if (entry.texture != nullptr) {
+        SDL_DestroyTexture(entry.texture);
+        entry.texture = nullptr;
+        resident -= entry.bytes;
+        recentlyUsed.erase(entry.recent);
+        entry.recent = recentlyUsed.end();
+        ++evictionCount;
+    }
+
+    // Nobody holds it anymore, forget it completely
+    if (entry.references == 0) {
+        for (auto path = pathKeys.begin(); path != pathKeys.end();) {
+            path = path->second == key ? pathKeys.erase(path) : std::next(path);
+        }
+        entries.erase(found);
+    }
+}
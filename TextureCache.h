@@ -0,0 +1,82 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+class TextureCache;
+
+/* Reference counted handle to a texture in a TextureCache.
+get() reloads the texture if the cache evicted it to stay within its budget. */
+class TextureHandle
+{
+public:
+    TextureHandle() {}
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other);
+    TextureHandle& operator=(TextureHandle other);
+    ~TextureHandle();
+
+    SDL_Texture* get() const;
+    void reset();
+    explicit operator bool() const { return cache != nullptr; }
+
+private:
+    friend class TextureCache;
+    TextureHandle(TextureCache* cache, uint64_t key) : cache(cache), key(key) {}
+
+    TextureCache* cache = nullptr;
+    uint64_t key = 0;
+};
+
+/* Decoded images keyed by a hash of the file contents, so identical files share one texture.
+Textures are kept in least recently used order and the oldest ones are destroyed while the
+estimated video memory use is over the budget. */
+class TextureCache
+{
+public:
+    TextureCache() {}
+    ~TextureCache();
+
+    void init(SDL_Renderer* renderer, size_t budgetBytes);
+    TextureHandle load(const std::string& path);
+    void trim();       // Evict down to the budget, call between frames
+    void invalidate(); // Forget every texture after the device was lost, handles reload on next use
+    void clear();      // Destroy everything, call before the renderer goes away
+
+    void setBudget(size_t bytes) { budget = bytes; }
+    size_t residentBytes() const { return resident; }
+    unsigned long hits() const { return hitCount; }
+    unsigned long misses() const { return missCount; }
+    unsigned long evictions() const { return evictionCount; }
+
+private:
+    friend class TextureHandle;
+
+    struct Entry {
+        std::string path;     // Where to decode it from again after an eviction
+        SDL_Texture* texture; // nullptr while evicted
+        size_t bytes;
+        int references;
+        std::list<uint64_t>::iterator recent; // Position in the LRU list while resident
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    size_t budget = 0;
+    size_t resident = 0;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::unordered_map<std::string, uint64_t> pathKeys; // Paths already hashed
+    std::list<uint64_t> recentlyUsed;                   // Resident textures, most recent first
+    unsigned long hitCount = 0;
+    unsigned long missCount = 0;
+    unsigned long evictionCount = 0;
+
+    static bool readFile(const std::string& path, std::string& bytes);
+    static uint64_t hashContents(const std::string& bytes);
+    bool decode(Entry& entry, const std::string& bytes);
+    void retain(uint64_t key);
+    void release(uint64_t key);
+    SDL_Texture* use(uint64_t key);
+    void evict(uint64_t key);
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/* Hands the latest value from one writer thread to one reader thread without locks.
+The writer fills back() and publishes it, the reader picks up the newest published value with
+update() and reads it through front(). Neither side ever waits for the other: values the reader
+was too slow to see are simply overwritten. */
+template <class T>
+class TripleBuffer
+{
+public:
+    // Writer side
+    T& back() { return slots[backIndex]; }
+    void publish() { backIndex = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel) & INDEX; }
+
+    // Reader side, true when a value newer than the current front was published
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static const uint8_t INDEX = 3;
+    static const uint8_t FRESH = 4; // Set in middle while it holds a value the reader hasn't taken
+
+    T slots[3];
+    uint8_t backIndex = 0;
+    char pad1[64];
+    std::atomic<uint8_t> middle{ 1 };
+    char pad2[64];
+    uint8_t frontIndex = 2;
+};
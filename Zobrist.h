@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+/* Keys for the incremental board hash.
+Instead of a table of random numbers sized for one board, every key is derived from the feature and
+its coordinates with splitmix64. The keys are the same in every process and for every board size,
+so hashes can be compared between replays and between players. */
+enum class ZobristFeature : uint64_t { SNAKE = 1, HEAD, DIRECTION, FOOD, POO, SCORE };
+
+inline uint64_t zobristKey(ZobristFeature feature, int a, int b = 0) {
+    uint64_t z = (static_cast<uint64_t>(feature) << 56) ^ (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 24) ^ static_cast<uint32_t>(b);
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}